@@ -7,8 +7,30 @@
 #include <array>
 #include <iostream>
 #include <format>
+#include <algorithm>
+#include <climits>
+#include <memory>
 
 #include "headers/gameobject.h"
+#include "headers/entitystore.h"
+#include "headers/spatialgrid.h"
+#include "headers/sweep.h"
+#include "headers/tilemap.h"
+#include "headers/spritebatch.h"
+#include "headers/atlas.h"
+#include "headers/tilechunks.h"
+#include "headers/surfaceloader.h"
+#include "headers/levelfile.h"
+#include "headers/worldstream.h"
+#include "headers/jobpool.h"
+#include "headers/profiler.h"
+#include "headers/inputrecord.h"
+#include "headers/particles.h"
+#include "headers/snapshot.h"
+#include "headers/transport.h"
+#include "headers/rollback.h"
+#include "headers/framepacer.h"
+#include "headers/rendercapture.h"
 
 using namespace std;
 
@@ -18,139 +40,517 @@ struct SDLState
     SDL_Renderer *renderer;
     int width, height, logW, logH;
     const bool *keys;
-    SDLState() : keys(SDL_GetKeyboardState(nullptr)) {
+    SDLState() : window(nullptr), renderer(nullptr), keys(SDL_GetKeyboardState(nullptr)) {
 
     }
 };
 
-const size_t LAYER_IDX_LEVEL = 0;
-const size_t LAYER_IDX_CHARACTERS = 1;
-
 const int MAP_ROWS = 5;
 const int MAP_COLS = 50;
 const int TILE_SIZE = 32;
+const int CULL_MARGIN = TILE_SIZE; // drawn area around the camera, covers sprites bigger than their colliders
+const int CHUNK_COLS = 32; // columns per baked tile chunk, wider than the screen so at most two are visible
+const int STREAM_CHUNK_COLS = 32; // columns per simulation chunk, see WorldStream
+
+const int DEFAULT_TICK_RATE = 60; // simulation ticks per second, 0 steps once per rendered frame
+const int DEFAULT_TARGET_FPS = 120; // frame rate of target pacing without --fps
+const int MAX_CATCHUP_STEPS = 5; // ticks allowed per frame before we drop time instead
+const float GRAVITY = 700;
+const int DEFAULT_BULLET_CAP = 512; // live bullets, storage for this many is allocated up front
+const int JOB_GRAIN = 256; // entities per job pool chunk in the parallel phases of a tick
+const int DEFAULT_PARTICLE_CAP = 100000; // live effect particles, allocated up front
+const float AI_AWARE_RADIUS = 100; // enemies this close to the player go after it
+const int AI_MID_PERIOD = 2; // ticks between logic updates of enemies within a screen of the camera, see scheduleAI
+const int AI_FAR_PERIOD = 4; // and of the ones further out
+const int MAX_PLAYERS = 2; // player 0 is the keyboard, player 1 only plays over a rollback session
+const int MAX_ROLLBACK = 8; // ticks a rollback session runs ahead of the other side's inputs, and so the most it resimulates
+const int DEFAULT_NET_LATENCY_MS = 50; // one way, of the loopback link
+const int REWIND_STRIDE = 4; // ticks between rewind snapshots, rewinding plays back this many times as fast
+const int REWIND_SNAPSHOTS = 150; // how many are kept, 10 seconds at 60 Hz
+const int DEFAULT_CAPTURE_FRAMES = 60; // frames recorded by --capture and F8, see RenderCapture
+const char *const DEFAULT_CAPTURE_PATH = "frames.rcap"; // where F8 writes without --capture
+
+// what firing does once the bullet pool is full
+enum class PoolOverflow {
+    drop, // the new shot is not fired
+    recycle // overwrite live bullets, round robin
+};
+
+// sprite batch layers, drawn lowest first
+const int LAYER_SKY = 0;
+const int LAYER_BG_FAR = 1; // parallax backgrounds
+const int LAYER_BG_MID = 2;
+const int LAYER_BG_NEAR = 3;
+const int LAYER_TILES = 4; // background decoration and level tiles, baked together
+const int LAYER_CHARACTERS = 5;
+const int LAYER_BULLETS = 6;
+const int LAYER_FG_TILES = 7;
+
+// frame profiler phases, in the order they run. names and colors below
+enum ProfilePhase {
+    PHASE_PACE, // sleeping until the frame should start, see FramePacer
+    PHASE_EVENTS,
+    PHASE_STREAM,
+    PHASE_UPDATE, // character logic
+    PHASE_BULLETS, // bullet logic and release
+    PHASE_INTEGRATE,
+    PHASE_COLLISION, // broadphase, detect and resolve
+    PHASE_DRAW_WORLD, // clear, backgrounds and tile chunks
+    PHASE_DRAW_SPRITES, // culling and queueing characters and bullets
+    PHASE_FLUSH, // sprite batch to the renderer
+    PHASE_PARTICLES, // update and draw effects
+    PHASE_DEBUG, // F12 overlay
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+const SDL_Color PHASE_COLORS[PHASE_COUNT] = {
+    { 70, 70, 110, 255 },
+    { 200, 200, 200, 255 },
+    { 120, 80, 200, 255 },
+    { 80, 160, 255, 255 },
+    { 255, 220, 60, 255 },
+    { 60, 220, 200, 255 },
+    { 255, 90, 70, 255 },
+    { 90, 200, 90, 255 },
+    { 170, 240, 110, 255 },
+    { 255, 150, 40, 255 },
+    { 255, 120, 160, 255 },
+    { 230, 100, 220, 255 },
+    { 255, 255, 255, 255 }
+};
+
+// particle effects triggered by collisions and shots, see ParticleSystem
+const ParticleBurst BURST_MUZZLE = { .count = 6, .speed = 120, .spread = 0.6f, .life = 0.12f, .size = 2, .color = { 1, 0.85f, 0.4f, 1 } };
+const ParticleBurst BURST_BULLET_HIT = { .count = 14, .speed = 160, .spread = 2.4f, .life = 0.3f, .size = 2, .color = { 1, 0.55f, 0.15f, 1 } };
+const ParticleBurst BURST_ENEMY_DEATH = { .count = 60, .speed = 220, .spread = 0, .life = 0.8f, .size = 3, .color = { 0.55f, 0.9f, 0.35f, 1 } };
+const ParticleBurst BURST_PLAYER_DEATH = { .count = 120, .speed = 260, .spread = 0, .life = 1.2f, .size = 3, .color = { 1, 0.25f, 0.2f, 1 } };
+
+// tile ids kept in the GameState tile maps, same codes as the map arrays in builtinLevel
+const uint8_t TILE_STONE = 1;
+const uint8_t TILE_BRICK = 2;
+const uint8_t TILE_GRASS = 5;
+const uint8_t TILE_BUSH = 6;
+const uint8_t TILE_FENCE = 7;
+
+// something an entity may touch this tick, found by detectContacts and applied by resolveContacts.
+// other is a character index, or -1 for the solid tile at row, col
+struct Contact {
+    int row, col;
+    int other;
+};
+// contacts written by one job pool thread
+struct ContactList {
+    std::vector<Contact> contacts;
+    std::vector<int> candidates; // scratch for grid queries
+    GridQuery query;
+};
+// where one entity's contacts are, they are always in a single list
+struct ContactSpan {
+    int list;
+    uint32_t begin, count;
+};
+
+// the dynamic part of a level right after it was loaded, restartLevel copies it back. tiles
+// aren't in here, nothing changes them during play
+struct LevelSnapshot {
+    EntityStore characters;
+    WorldStream stream; // with everything away from the camera parked
+    int playerIndices[MAX_PLAYERS];
+    float viewportX;
+};
 
 struct GameState {
-    std::array<std::vector<GameObject>, 2> layers;
-    std::vector<GameObject> bgTiles;
-    std::vector<GameObject> fgTiles;
-    std::vector<GameObject> bullets;
-    int playerIndex;
-    SDL_FRect mapViewport;
+    EntityStore characters; // player and enemies
+    EntityStore bullets; // only live bullets, packed at the front, see spawnBullet and releaseBullets
+    size_t bulletCap;
+    PoolOverflow bulletOverflow;
+    size_t bulletRecycle; // next slot to overwrite when recycling
+    int bulletsDropped; // shots lost to a full pool
+    TileMap tiles; // solid level geometry
+    TileMap bgTiles, fgTiles; // decoration drawn behind and in front of the characters
+    TileChunks backChunks, frontChunks; // bgTiles + tiles and fgTiles pre-rendered, see setupTileChunks
+    LevelFile levelFile; // mapped level the tile maps view, see loadLevelFile
+    WorldStream stream; // which part of the level is simulated, see streamWorld
+    bool streaming; // off keeps the whole level active
+    std::vector<int> enteredChunks, leftChunks; // scratch for streamWorld
+    std::vector<ParkedEnemy> unparked; // scratch for streamWorld, a chunk coming back
+    int playerIndices[MAX_PLAYERS]; // character index of each player, -1 for none
+    int playerCount; // players the level is set up for, the ones without a spawn start with player 0
+    SDL_FRect mapViewport; // camera used by the simulation
+    float prevViewportX; // camera position at the start of the last tick
+    SDL_FRect drawViewport; // camera interpolated for the frame being drawn
+    float interpAlpha; // how far the frame is between the previous and the current tick
     float bg2Scroll, bg3Scroll, bg4Scroll;
     bool debugMode;
+    // broadphase over characters, grid ids are character indices. rebuilt every tick
+    SpatialGrid grid;
+    JobPool jobs; // runs the parallel phases of stepSimulation
+    std::vector<ContactList> contactLists; // one per job pool thread
+    std::vector<ContactSpan> contactSpans; // per character, then per bullet
+    FrameProfiler profiler; // phase timings of the last frames, see drawProfiler
+    ParticleSystem particles; // effects, emitted by the collision responses and updated per frame
+    std::vector<int> visibleCharacters, visibleBullets; // what the frame being drawn can see, see cullSprites
+    bool aiLod; // off runs every enemy's logic every tick
+    std::vector<uint8_t> aiPeriod; // per character, ticks between logic updates, see scheduleAI
+    int aiUpdates; // enemy logic updates this tick
+    std::vector<int> found; // scratch for findCharacters
+    GridQuery foundQuery;
+    uint64_t tick; // ticks simulated, staggers the AI updates
+    uint64_t rng; // state of the simulation's random numbers, seeded with the session seed
+    SnapshotRing rewind; // recent ticks to go back to while R is held, see keepRewindSnapshot
+    double snapshotMS; // how long the last capture took
+    LevelSnapshot initial; // taken by finishLevel, see restartLevel
+    bool restartPending; // the player is done dying, the level restarts at the end of the tick
+    int restarts;
+    double restartMS; // how long the last restart took
+    int candidatePairs, collisionHits; // debug counters, reset every tick
+    uint8_t inputs[MAX_PLAYERS]; // INPUT_ bits of each player for the tick being simulated, see stepSimulation
 
-    GameState(const SDLState &state) {
-        playerIndex = -1; // will change when map is loaded
+    GameState(const SDLState &state) : profiler({ "pace", "events", "stream", "update", "bullets", "integrate", "collision",
+                                                  "draw_world", "draw_sprites", "flush", "particles", "debug", "present" }) {
+        std::fill(playerIndices, playerIndices + MAX_PLAYERS, -1); // will change when map is loaded
+        playerCount = 1;
         mapViewport = SDL_FRect {
             .x = 0,
             .y = 0,
             .w = static_cast<float>(state.logW),
             .h = static_cast<float>(state.logH)
         };
+        prevViewportX = 0;
+        drawViewport = mapViewport;
+        interpAlpha = 1;
         bg2Scroll = bg3Scroll = bg4Scroll = 0;
         debugMode = false;
+        streaming = true;
+        candidatePairs = collisionHits = 0;
+        std::fill(inputs, inputs + MAX_PLAYERS, 0);
+        aiLod = true;
+        aiUpdates = 0;
+        tick = 0;
+        rng = 0;
+        snapshotMS = 0;
+        std::fill(initial.playerIndices, initial.playerIndices + MAX_PLAYERS, -1);
+        initial.viewportX = 0;
+        restartPending = false;
+        restarts = 0;
+        restartMS = 0;
+        bulletCap = 0;
+        bulletOverflow = PoolOverflow::drop;
+        bulletRecycle = 0;
+        bulletsDropped = 0;
     }
-    GameObject &player() {
-        return layers[LAYER_IDX_CHARACTERS][playerIndex];
+    void setBulletPool(size_t cap, PoolOverflow overflow) {
+        bulletCap = cap;
+        bulletOverflow = overflow;
+        bullets.reserve(cap);
+    }
+    Entity player(int slot = 0) {
+        return characters[playerIndices[slot]];
     }
 };
 
 struct Resources {
+    // clip ids, index into animations
     const int ANIM_PLAYER_IDLE = 0;
     const int ANIM_PLAYER_RUN = 1;
     const int ANIM_PLAYER_SLIDE = 2;
     const int ANIM_PLAYER_SHOOT = 3;
     const int ANIM_PLAYER_JUMP = 4;
     const int ANIM_PLAYER_DIE = 5;
-    std::vector<Animation> playerAnims;
-    const int ANIM_BULLET_MOVING = 0;
-    const int ANIM_BULLET_HIT = 1;
-    std::vector<Animation> bulletAnims;
-    const int ANIM_ENEMY = 0;
-    const int ANIM_ENEMY_DEAD = 1;
-    std::vector<Animation> enemyAnims;
-
-    std::vector<SDL_Texture *> textures;
-    SDL_Texture *texIdle, *texRun, *texJump, *texSlide, *texShoot, *texDie, 
-                *texGrass, *texStone, *texBrick, *texFence, *texBush, 
-                *texBullet, *texBulletHit, *texSpiny, *texSpinyDead,
-                *texBg1, *texBg2, *texBg3, *texBg4;
-
-    SDL_Texture *loadTexture(SDL_Renderer *renderer, const std::string &filepath) { // load texture from filepath
-        // load game assets
-        SDL_Texture *tex = IMG_LoadTexture(renderer, filepath.c_str());
-        SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST); // pixel perfect
-        textures.push_back(tex);
-        return tex;
+    const int ANIM_BULLET_MOVING = 6;
+    const int ANIM_BULLET_HIT = 7;
+    const int ANIM_ENEMY = 8;
+    const int ANIM_ENEMY_DEAD = 9;
+    std::vector<Animation> animations; // shared by every object, objects only keep a clip id and a clock
+    // collider sizes of the fireball sprites, the simulation never reads textures so it can run headless
+    const float BULLET_SIZE = 8;
+    const float BULLET_HIT_SIZE = 16;
+
+    // sprite ids, index into sprites
+    const int SPR_IDLE = 0;
+    const int SPR_RUN = 1;
+    const int SPR_JUMP = 2;
+    const int SPR_SLIDE = 3;
+    const int SPR_SHOOT = 4;
+    const int SPR_DIE = 5;
+    const int SPR_BULLET = 6;
+    const int SPR_BULLET_HIT = 7;
+    const int SPR_SPINY = 8;
+    const int SPR_SPINY_DEAD = 9;
+    const int SPR_GRASS = 10;
+    const int SPR_BRICK = 11;
+    const int SPR_STONE = 12;
+    const int SPR_BUSH = 13;
+    const int SPR_FENCE = 14;
+    const int SPRITE_COUNT = 15;
+    const int VARIANT_COUNT = 8; // SPR_IDLE up to SPR_BULLET_HIT come in an L and an M version
+    std::vector<Sprite> sprites; // regions of the atlas pages
+    std::vector<Sprite> variantL, variantM; // both versions are packed, sprites holds the chosen one
+    std::array<Sprite, 256> tileSprites; // indexed by tile id, one per byte value so ids from level files stay in range
+
+    std::vector<SDL_Texture *> textures; // atlas pages and backgrounds
+    SDL_Texture *texBg1, *texBg2, *texBg3, *texBg4; // screen sized and tiled while scrolling, kept out of the atlas
+
+    // time spent on each asset during load(), see printLoadReport
+    struct LoadTiming {
+        std::string name;
+        uint64_t decodeNS, uploadNS;
+    };
+    std::vector<LoadTiming> loadTimings;
+    uint64_t loadNS; // wall time of the whole load
+
+    void selectVariant(bool real) {
+        const std::vector<Sprite> &variant = real ? variantL : variantM;
+        std::copy(variant.begin(), variant.end(), sprites.begin());
     }
 
     void load(SDLState &state, bool real) {
-        playerAnims.resize(6); // 
-        playerAnims[ANIM_PLAYER_IDLE] = Animation(1, 1.6f); // 1 frames, 1.6 seconds
-        playerAnims[ANIM_PLAYER_RUN] = Animation(3, 0.3f);
-        playerAnims[ANIM_PLAYER_SLIDE] = Animation(1, 1.0f);
-        playerAnims[ANIM_PLAYER_SHOOT] = Animation(1, 0.3f);
-        playerAnims[ANIM_PLAYER_JUMP] = Animation(1, 1.0f); 
-        playerAnims[ANIM_PLAYER_DIE] = Animation(1, 1.0f);
-        bulletAnims.resize(2); // 
-        bulletAnims[ANIM_BULLET_MOVING] = Animation(4, 0.5f);
-        bulletAnims[ANIM_BULLET_HIT] = Animation(3, 0.5f);
-        enemyAnims.resize(2);
-        enemyAnims[ANIM_ENEMY] = Animation(2, 0.6f);
-        enemyAnims[ANIM_ENEMY_DEAD] = Animation(1, 1.0f);
-
-        if (real) {
-            texIdle = loadTexture(state.renderer, "data/IdleL.png");
-            texRun = loadTexture(state.renderer, "data/WalkLRL.png");
-            texJump = loadTexture(state.renderer, "data/JumpL.png");
-            texSlide = loadTexture(state.renderer, "data/SlideL.png");
-            texShoot = loadTexture(state.renderer, "data/ShootL.png");
-            texDie = loadTexture(state.renderer, "data/DieL.png");
-            texBullet = loadTexture(state.renderer, "data/fireballL.png");
-            texBulletHit = loadTexture(state.renderer, "data/fireballHitL.png");
-        } else {
-            texIdle = loadTexture(state.renderer, "data/IdleM.png");
-            texRun = loadTexture(state.renderer, "data/WalkLRM.png");
-            texJump = loadTexture(state.renderer, "data/JumpM.png");
-            texSlide = loadTexture(state.renderer, "data/SlideM.png");
-            texShoot = loadTexture(state.renderer, "data/ShootM.png");
-            texDie = loadTexture(state.renderer, "data/DieM.png");
-            texBullet = loadTexture(state.renderer, "data/fireballM.png");
-            texBulletHit = loadTexture(state.renderer, "data/fireballHitM.png");
-        }
-        texGrass = loadTexture(state.renderer, "data/grass.png");
-        texBrick = loadTexture(state.renderer, "data/brick.png");
-        texStone = loadTexture(state.renderer, "data/stone.png");
-        texBush = loadTexture(state.renderer, "data/bush.png");
-        texFence = loadTexture(state.renderer, "data/fence.png");
-        texBg1 = loadTexture(state.renderer, "data/bg_layer1.png");
-        texBg2 = loadTexture(state.renderer, "data/bg_layer2.png");
-        texBg3 = loadTexture(state.renderer, "data/bg_layer3.png");
-        texBg4 = loadTexture(state.renderer, "data/bg_layer4.png");
-        texSpiny = loadTexture(state.renderer, "data/Spiny.png");
-        texSpinyDead = loadTexture(state.renderer, "data/SpinyDead.png");
+        animations.resize(10);
+        animations[ANIM_PLAYER_IDLE] = Animation(1, 1.6f); // 1 frames, 1.6 seconds
+        animations[ANIM_PLAYER_RUN] = Animation(3, 0.3f);
+        animations[ANIM_PLAYER_SLIDE] = Animation(1, 1.0f);
+        animations[ANIM_PLAYER_SHOOT] = Animation(1, 0.3f);
+        animations[ANIM_PLAYER_JUMP] = Animation(1, 1.0f); 
+        animations[ANIM_PLAYER_DIE] = Animation(1, 1.0f);
+        animations[ANIM_BULLET_MOVING] = Animation(4, 0.5f);
+        animations[ANIM_BULLET_HIT] = Animation(3, 0.5f);
+        animations[ANIM_ENEMY] = Animation(2, 0.6f);
+        animations[ANIM_ENEMY_DEAD] = Animation(1, 1.0f);
+
+        sprites.assign(SPRITE_COUNT, Sprite());
+        variantL.assign(VARIANT_COUNT, Sprite());
+        variantM.assign(VARIANT_COUNT, Sprite());
+        tileSprites.fill(Sprite());
+        texBg1 = texBg2 = texBg3 = texBg4 = nullptr;
+        loadTimings.clear();
+        loadNS = 0;
+        if (!state.renderer) { // headless, only the animation data is needed
+            return;
+        }
+        const uint64_t loadStart = SDL_GetTicksNS();
+        // stage 1, decode every png to a surface on worker threads
+        std::vector<DecodeJob> jobs;
+        std::vector<Sprite *> atlasTargets; // jobs[i] goes into the atlas for i < atlasTargets.size()
+        const auto addSprite = [&jobs, &atlasTargets](const std::string &filepath, Sprite *out) {
+            jobs.emplace_back(filepath);
+            atlasTargets.push_back(out);
+        };
+        const char *names[] = { "Idle", "WalkLR", "Jump", "Slide", "Shoot", "Die", "fireball", "fireballHit" };
+        for (int i = 0; i < VARIANT_COUNT; i++) {
+            addSprite(std::format("data/{}L.png", names[i]), &variantL[i]);
+            addSprite(std::format("data/{}M.png", names[i]), &variantM[i]);
+        }
+        addSprite("data/Spiny.png", &sprites[SPR_SPINY]);
+        addSprite("data/SpinyDead.png", &sprites[SPR_SPINY_DEAD]);
+        addSprite("data/grass.png", &sprites[SPR_GRASS]);
+        addSprite("data/brick.png", &sprites[SPR_BRICK]);
+        addSprite("data/stone.png", &sprites[SPR_STONE]);
+        addSprite("data/bush.png", &sprites[SPR_BUSH]);
+        addSprite("data/fence.png", &sprites[SPR_FENCE]);
+        SDL_Texture **bgTargets[] = { &texBg1, &texBg2, &texBg3, &texBg4 }; // the rest are standalone textures
+        for (int i = 0; i < 4; i++) {
+            jobs.emplace_back(std::format("data/bg_layer{}.png", i + 1));
+        }
+        decodeSurfaces(jobs, SDL_GetNumLogicalCPUCores());
+
+        // stage 2, upload on this thread since it owns the renderer
+        for (const DecodeJob &job : jobs) {
+            if (!job.surface) {
+                SDL_Log("Failed to load %s: %s", job.path.c_str(), job.error.c_str());
+            }
+            loadTimings.push_back(LoadTiming { .name = job.path, .decodeNS = job.decodeNS, .uploadNS = 0 });
+        }
+        // every small image goes into the atlas so switching sprites rarely switches textures
+        uint64_t uploadStart = SDL_GetTicksNS();
+        AtlasBuilder atlas;
+        for (size_t i = 0; i < atlasTargets.size(); i++) {
+            atlas.add(jobs[i].surface, atlasTargets[i]);
+        }
+        const std::vector<SDL_Texture *> pages = atlas.build(state.renderer);
+        textures.insert(textures.end(), pages.begin(), pages.end());
+        loadTimings.push_back(LoadTiming { .name = std::format("atlas, {} pages", pages.size()),
+                                           .decodeNS = 0, .uploadNS = SDL_GetTicksNS() - uploadStart });
+        selectVariant(real);
+        for (size_t i = atlasTargets.size(); i < jobs.size(); i++) {
+            uploadStart = SDL_GetTicksNS();
+            SDL_Texture *tex = SDL_CreateTextureFromSurface(state.renderer, jobs[i].surface);
+            SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST); // pixel perfect
+            SDL_DestroySurface(jobs[i].surface);
+            textures.push_back(tex);
+            *bgTargets[i - atlasTargets.size()] = tex;
+            loadTimings[i].uploadNS = SDL_GetTicksNS() - uploadStart;
+        }
+        loadNS = SDL_GetTicksNS() - loadStart;
+
+        tileSprites[TILE_STONE] = sprites[SPR_STONE];
+        tileSprites[TILE_BRICK] = sprites[SPR_BRICK];
+        tileSprites[TILE_GRASS] = sprites[SPR_GRASS];
+        tileSprites[TILE_BUSH] = sprites[SPR_BUSH];
+        tileSprites[TILE_FENCE] = sprites[SPR_FENCE];
+    }
+
+    void printLoadReport() const {
+        uint64_t decodeNS = 0, uploadNS = 0;
+        for (const LoadTiming &t : loadTimings) {
+            printf("%-28s decode %7.2f ms, upload %7.2f ms\n", t.name.c_str(), t.decodeNS / 1e6, t.uploadNS / 1e6);
+            decodeNS += t.decodeNS;
+            uploadNS += t.uploadNS;
+        }
+        printf("assets loaded in %.2f ms (decode %.2f ms over all threads, upload %.2f ms)\n",
+               loadNS / 1e6, decodeNS / 1e6, uploadNS / 1e6);
     }
 
     void unload() {
         for (SDL_Texture *tex : textures) {
             SDL_DestroyTexture(tex);
         }
+        textures.clear();
     }
 };
 
-bool initialize(SDLState &state);
+bool initialize(SDLState &state, bool vsync);
 void cleanup(SDLState &state);
-void drawObject(const SDLState &state, GameState &gs, GameObject &obj, float width, float height, float deltaTime);
-void update(const SDLState &state, GameState &gs, Resources &res, GameObject &obj, float deltaTime);
+void drawObject(GameState &gs, const Resources &res, SpriteBatch &batch, int layer, Entity obj, float width, float height, float deltaTime);
+void drawCollider(const SDLState &state, const GameState &gs, Entity obj);
+void drawTileColliders(const SDLState &state, const GameState &gs, const TileMap &tiles);
+void stepSimulation(const SDLState &state, GameState &gs, Resources &res, float deltaTime, const uint8_t *inputs);
+void stepSimulation(const SDLState &state, GameState &gs, Resources &res, float deltaTime, uint8_t input);
+float cameraX(GameState &gs);
+bool playersDead(GameState &gs);
+uint8_t heldInput(const bool *keys);
+bool isGameKey(SDL_Scancode key);
+void update(const SDLState &state, GameState &gs, Resources &res, Entity obj, float deltaTime);
+void detectContacts(const GameState &gs, const EntityStore &store, size_t i, int gridId, int list, ContactList &out, ContactSpan &span);
+void resolveContacts(const SDLState &state, GameState &gs, Resources &res, Entity obj, const ContactSpan &span, float deltaTime);
+
+// a level held in memory, laid out like a level file
+struct LevelBuffer {
+    int rows, cols;
+    std::vector<uint8_t> layers[LEVEL_LAYER_COUNT]; // column major tile ids, see LevelLayer
+    std::vector<LevelSpawn> spawns;
+    LevelBuffer(int rows, int cols) : rows(rows), cols(cols) {
+        for (std::vector<uint8_t> &layer : layers) {
+            layer.assign(static_cast<size_t>(rows) * cols, 0);
+        }
+    }
+};
+LevelBuffer builtinLevel();
+void convertTileCodes(const short *codes, LevelBuffer &level);
+bool exportLevel(const char *path);
 void createTiles(const SDLState &state, GameState &gs, const Resources &res);
-void checkCollision(const SDLState &state, GameState &gs, const Resources &res, GameObject &a, GameObject &b, float deltaTime);
+void loadLevel(const SDLState &state, GameState &gs, const Resources &res, const LevelBuffer &level);
+bool loadLevelFile(const SDLState &state, GameState &gs, const Resources &res, const char *path);
+void clearLevel(const SDLState &state, GameState &gs, int rows, int cols);
+void clearEntities(GameState &gs);
+bool spawnAll(const SDLState &state, GameState &gs, const Resources &res, const LevelSpawn *spawns, int count);
+glm::vec2 cellPos(const GameState &gs, int r, int c);
+void spawnEnemy(const SDLState &state, GameState &gs, const Resources &res, int r, int c);
+size_t spawnEnemyAt(GameState &gs, const Resources &res, glm::vec2 pos);
+void spawnPlayer(const SDLState &state, GameState &gs, const Resources &res, int r, int c);
+void spawnPlayerAt(GameState &gs, const Resources &res, glm::vec2 pos);
+void finishLevel(const SDLState &state, GameState &gs, const Resources &res);
+void restartLevel(const SDLState &state, GameState &gs);
+void fitGrid(const SDLState &state, GameState &gs);
+void captureSnapshot(const GameState &gs, WorldSnapshot &snap);
+bool restoreSnapshot(const SDLState &state, GameState &gs, const WorldSnapshot &snap);
+void keepRewindSnapshot(GameState &gs);
+void rewindTick(const SDLState &state, GameState &gs);
+void setupTileChunks(const SDLState &state, GameState &gs, const Resources &res);
+bool streamWorld(const SDLState &state, GameState &gs, const Resources &res);
+void buildBroadphase(GameState &gs);
+void findCharacters(const GameState &gs, const SDL_FRect &rect, ObjectType type, std::vector<int> &out, GridQuery &q);
+void findCharacters(const GameState &gs, glm::vec2 center, float radius, ObjectType type, std::vector<int> &out, GridQuery &q);
+void scheduleAI(GameState &gs);
+glm::vec2 colliderCenter(Entity obj);
+void cullSprites(GameState &gs);
+bool checkCollision(const SDLState &state, GameState &gs, const Resources &res, Entity a, Entity b, float deltaTime);
 void collisionResponse(const SDLState &state, GameState &gs, const Resources &res, 
-                       const SDL_FRect &rectA, const SDL_FRect &rectB, 
-                       const SDL_FRect &rectC, GameObject &a, GameObject &b, float deltaTime);
-void handleKeyInput(const SDLState &state, GameState &gs, GameObject &obj,
+                       const SDL_FRect &rectB, glm::vec2 normal,
+                       Entity a, Entity b, float deltaTime);
+void sweepTiles(GameState &gs, const Resources &res, Entity obj, const Contact *tiles, size_t count);
+bool collidesWithLevel(const GameObject &obj);
+void levelResponse(GameState &gs, const Resources &res, const SDL_FRect &cell, glm::vec2 normal, Entity a);
+void handleKeyInput(const SDLState &state, GameState &gs, Entity obj,
                     SDL_Scancode key, bool keyDown);
-void drawParallaxBackground(SDL_Renderer *renderer, SDL_Texture *texture, float xVelocity, float &scrollPos, float scrollFactor, float deltaTime);
+void drawParallaxBackground(SpriteBatch &batch, int layer, SDL_Texture *texture, float xVelocity, float &scrollPos, float scrollFactor, float deltaTime);
+void drawProfiler(const SDLState &state, GameState &gs);
+
+void spawnBullet(GameState &gs, const Body &body, const GameObject &bullet);
+void releaseBullets(GameState &gs);
+
+// one side of a rollback session: its own world, every player's inputs by tick, the worlds at
+// the start of the last ticks to go back to and the connection to the other side, see netTick
+struct NetPeer {
+    GameState &gs;
+    Transport &transport;
+    int localSlot; // the player this side controls
+    RollbackInputs inputs;
+    std::vector<WorldSnapshot> saved; // the world at the start of tick t is in saved[t % size]
+    int tick; // next tick to simulate
+    int remoteAck; // the other side has our inputs of every tick before this
+    std::vector<uint8_t> packet; // scratch
+    int rollbacks, lastDepth, maxDepth, stalls;
+    double lastResimMS; // restoring and simulating again, of the last rollback
+    std::vector<double> resimTimes; // of every rollback, for reports
+    bool desynced; // a rollback couldn't restore its saved world, this side no longer follows the other and the session is over
+    NetPeer(GameState &gs, Transport &transport, int localSlot) : gs(gs), transport(transport), localSlot(localSlot),
+        saved(MAX_ROLLBACK + 1), tick(0), remoteAck(0), rollbacks(0), lastDepth(0), maxDepth(0), stalls(0), lastResimMS(0),
+        desynced(false) {
+        inputs.setup(MAX_PLAYERS);
+    }
+};
+
+// a two player rollback session against a second peer in the same process, over a loopback
+// link. the other side has a world of its own that is never drawn
+struct NetSession {
+    LoopbackLink link;
+    GameState remoteGs;
+    NetPeer local, remote;
+    NetSession(const SDLState &state, GameState &gs, uint64_t latencyNS, float loss) : link(latencyNS, loss), remoteGs(state),
+        local(gs, link.getEnd(0), 0), remote(remoteGs, link.getEnd(1), 1) {
+
+    }
+};
+bool netTick(const SDLState &state, NetPeer &peer, Resources &res, float deltaTime, uint8_t localInput, bool advance);
+void simulateNetTick(const SDLState &state, NetPeer &peer, Resources &res, float deltaTime, int tick);
+
+// procedurally generated headless benchmark, see runStress
+struct StressConfig {
+    int ticks;
+    int enemies;
+    int cols;
+    uint64_t seed;
+    float fireInterval; // seconds between the player's shots, 0 keeps the normal weapon
+    const char *levelPath; // level file to run instead of the generated level
+    bool streaming; // off simulates every character, not just the ones near the camera
+    bool aiLod; // off runs every enemy's logic every tick
+    int threads; // job pool size, 0 for every hardware thread
+    size_t profileFrames; // ticks the profiler keeps
+    const char *profileCSV; // where to write the profiler samples at the end, nullptr for nowhere
+    bool verifyThreads; // run again on one thread and compare the world every tick
+    size_t particleCap; // effects are updated every tick like in a frame, but never drawn
+    int restartEvery; // ticks between level restarts, 0 never restarts
+    bool snapshotBench; // time capturing and restoring the final world and check a restore simulates the same
+    bool netplay; // two players in a rollback session over a loopback link instead, see runNetplay
+    int netLatencyMS; // one way
+    float netLoss; // share of packets lost, 0..1
+    StressConfig() : ticks(3000), enemies(2000), cols(2000), seed(1), fireInterval(0), levelPath(nullptr), streaming(true), aiLod(true),
+                     threads(0), profileFrames(1000), profileCSV(nullptr), verifyThreads(false), particleCap(DEFAULT_PARTICLE_CAP),
+                     restartEvery(0), snapshotBench(false), netplay(false), netLatencyMS(DEFAULT_NET_LATENCY_MS), netLoss(0) {
+
+    }
+};
+int runStress(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow);
+void simulateStress(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow,
+                    int threads, std::vector<uint64_t> *checksums, bool report);
+uint64_t worldChecksum(GameState &gs);
+int runReplay(SDLState &state, const char *path, int threads);
+void createStressLevel(const SDLState &state, GameState &gs, const Resources &res, const StressConfig &cfg);
+void setupStressWorld(SDLState &state, GameState &gs, const Resources &res, const StressConfig &cfg, size_t bulletCap,
+                      PoolOverflow bulletOverflow, int threads);
+int runNetplay(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow);
+uint8_t stressInput(int tick, int tickRate);
+void benchSnapshots(SDLState &state, GameState &gs, Resources &res, int tickRate, int firstTick);
 
 bool running = true;
 
@@ -161,28 +561,207 @@ int main(int argc, char** argv) { // SDL needs to hijack main to do stuff; inclu
     state.logW = 640;
     state.logH = 480;
 
-    // go to result when you die, should probably change!!!!
-    //main_loop: absolutely do not use this holy shit my computer almost crashed. fork bomb!
     bool l = false;
-    if (argc > 1 && !strcmp(argv[1], "l")) {
-        l = true;
+    int tickRate = DEFAULT_TICK_RATE;
+    bool headless = false;
+    bool loadReport = false;
+    StressConfig stress;
+    const char *levelPath = nullptr;
+    const char *exportPath = nullptr;
+    bool streaming = true;
+    bool aiLod = true;
+    int threads = 0;
+    size_t profileFrames = 1000;
+    const char *profileCSV = nullptr;
+    size_t bulletCap = DEFAULT_BULLET_CAP;
+    PoolOverflow bulletOverflow = PoolOverflow::drop;
+    size_t particleCap = DEFAULT_PARTICLE_CAP;
+    bool seeded = false;
+    PacingMode pacing = PacingMode::vsync;
+    int targetFPS = DEFAULT_TARGET_FPS;
+    const char *recordPath = nullptr;
+    const char *replayPath = nullptr;
+    const char *capturePath = nullptr;
+    int captureFrames = DEFAULT_CAPTURE_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "l")) {
+            l = true;
+        } else if (!strcmp(argv[i], "--tick-rate") && i + 1 < argc) {
+            tickRate = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--load-report")) {
+            loadReport = true;
+        } else if (!strcmp(argv[i], "--level") && i + 1 < argc) {
+            levelPath = argv[++i];
+        } else if (!strcmp(argv[i], "--export-level") && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--profile-frames") && i + 1 < argc) {
+            profileFrames = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "--profile-csv") && i + 1 < argc) {
+            profileCSV = argv[++i];
+        } else if (!strcmp(argv[i], "--verify-threads")) {
+            stress.verifyThreads = true;
+        } else if (!strcmp(argv[i], "--no-stream")) {
+            streaming = false;
+        } else if (!strcmp(argv[i], "--no-ai-lod")) {
+            aiLod = false;
+        } else if (!strcmp(argv[i], "--headless")) {
+            headless = true;
+        } else if (!strcmp(argv[i], "--ticks") && i + 1 < argc) {
+            stress.ticks = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "--enemies") && i + 1 < argc) {
+            stress.enemies = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--cols") && i + 1 < argc) {
+            stress.cols = std::max(atoi(argv[++i]), 16);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            stress.seed = strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        } else if (!strcmp(argv[i], "--fire-interval") && i + 1 < argc) {
+            stress.fireInterval = std::max(static_cast<float>(atof(argv[++i])), 0.0f);
+        } else if (!strcmp(argv[i], "--bullet-cap") && i + 1 < argc) {
+            bulletCap = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "--bullet-overflow") && i + 1 < argc) {
+            bulletOverflow = !strcmp(argv[++i], "recycle") ? PoolOverflow::recycle : PoolOverflow::drop;
+        } else if (!strcmp(argv[i], "--particle-cap") && i + 1 < argc) {
+            particleCap = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--restart-every") && i + 1 < argc) {
+            stress.restartEvery = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--snapshot-bench")) {
+            stress.snapshotBench = true;
+        } else if (!strcmp(argv[i], "--netplay")) {
+            stress.netplay = true;
+        } else if (!strcmp(argv[i], "--net-latency") && i + 1 < argc) {
+            stress.netLatencyMS = std::max(atoi(argv[++i]), 0);
+        } else if (!strcmp(argv[i], "--net-loss") && i + 1 < argc) {
+            stress.netLoss = std::clamp(static_cast<float>(atof(argv[++i])) / 100, 0.0f, 1.0f); // percent
+        } else if (!strcmp(argv[i], "--pacing") && i + 1 < argc) {
+            ++i;
+            pacing = !strcmp(argv[i], "uncapped") ? PacingMode::uncapped : !strcmp(argv[i], "target") ? PacingMode::target : PacingMode::vsync;
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            targetFPS = std::max(atoi(argv[++i]), 1);
+            pacing = PacingMode::target;
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (!strcmp(argv[i], "--capture-frames") && i + 1 < argc) {
+            captureFrames = std::max(atoi(argv[++i]), 1);
+        }
     }
-    if (!initialize(state)) {
+    if (exportPath) { // write the built in level as a level file and quit
+        return exportLevel(exportPath) ? 0 : 1;
+    }
+    if (replayPath) { // plays a recording back headless, as fast as it goes
+        return runReplay(state, replayPath, threads);
+    }
+    if (headless) { // no window, renderer or textures
+        stress.levelPath = levelPath;
+        stress.streaming = streaming;
+        stress.aiLod = aiLod;
+        stress.threads = threads;
+        stress.profileFrames = profileFrames;
+        stress.profileCSV = profileCSV;
+        stress.particleCap = particleCap;
+        if (stress.netplay) {
+            return runNetplay(state, tickRate ? tickRate : DEFAULT_TICK_RATE, stress, bulletCap, bulletOverflow);
+        }
+        return runStress(state, tickRate ? tickRate : DEFAULT_TICK_RATE, stress, bulletCap, bulletOverflow);
+    }
+    if (!initialize(state, pacing == PacingMode::vsync)) {
         return 1;
     }
     // load game assets
     Resources res;
     res.load(state, l);
+    if (loadReport) {
+        res.printLoadReport();
+    }
+    SpriteBatch batch; // every sprite of a frame goes through this
 
     // setup game data
     GameState gs(state);
-    createTiles(state, gs, res);
-    uint64_t prevTime = SDL_GetTicks();
+    gs.setBulletPool(bulletCap, bulletOverflow);
+    gs.particles.setCapacity(particleCap);
+    gs.streaming = streaming;
+    gs.aiLod = aiLod;
+    gs.jobs.setThreadCount(threads);
+    if (stress.netplay && !tickRate) {
+        SDL_Log("Rollback needs a fixed tick rate, playing alone");
+        stress.netplay = false;
+    }
+    gs.playerCount = stress.netplay ? 2 : 1;
+    // bullet spread is the only randomness of a session, a recording keeps the seed to roll the same numbers
+    const uint64_t seed = seeded ? stress.seed : SDL_GetPerformanceCounter();
+    SDL_srand(seed);
+    gs.rng = seed;
+    gs.rewind.setCapacity(REWIND_SNAPSHOTS);
+    const bool levelLoaded = levelPath && loadLevelFile(state, gs, res, levelPath);
+    if (!levelLoaded) {
+        createTiles(state, gs, res);
+    }
+    std::unique_ptr<NetSession> net; // --netplay: we are player 0, player 1 is scripted on the other side of a loopback link
+    if (stress.netplay) {
+        net = std::make_unique<NetSession>(state, gs, stress.netLatencyMS * SDL_NS_PER_MS, stress.netLoss);
+        GameState &remote = net->remoteGs; // set up like ours, so both sides simulate the same world
+        remote.playerCount = 2;
+        remote.setBulletPool(bulletCap, bulletOverflow);
+        remote.streaming = streaming;
+        remote.aiLod = aiLod;
+        remote.jobs.setThreadCount(threads);
+        remote.rng = seed;
+        if (!levelLoaded || !loadLevelFile(state, remote, res, levelPath)) {
+            createTiles(state, remote, res);
+        }
+    }
+    InputRecording recording;
+    if (recordPath && !tickRate) {
+        SDL_Log("Recording needs a fixed tick rate, not recording");
+        recordPath = nullptr;
+    }
+    if (recordPath && net) {
+        SDL_Log("Recordings have a single player, not recording");
+        recordPath = nullptr;
+    }
+    if (recordPath) {
+        recording.tickRate = tickRate;
+        recording.bulletCap = static_cast<uint32_t>(bulletCap);
+        recording.flags = (streaming ? InputRecording::FLAG_STREAMING : 0) |
+                          (bulletOverflow == PoolOverflow::recycle ? InputRecording::FLAG_RECYCLE_BULLETS : 0) |
+                          (aiLod ? InputRecording::FLAG_AI_LOD : 0);
+        recording.seed = seed;
+        if (levelLoaded) {
+            recording.levelPath = levelPath;
+        }
+    }
+    uint8_t pressed = 0; // INPUT_JUMP from key down events, kept until a tick consumes it
+    WorldSnapshot quickSave; // F5 takes it, F9 goes back to it
+    const uint64_t tickNS = tickRate ? SDL_NS_PER_SECOND / tickRate : 0;
+    uint64_t accumulator = 0;
+    FramePacer pacer;
+    pacer.setMode(pacing, targetFPS);
+    InputLatency latency; // key presses to the present that shows them
+    RenderCapture capture; // render commands for renderreplay, --capture starts with the first frame and F8 any time
+    int captureLeft = 0; // frames still to record
+    if (capturePath) {
+        capture.begin(state.logW, state.logH);
+        captureLeft = captureFrames;
+    }
+    uint64_t prevTime = SDL_GetTicksNS();
 
+    gs.profiler.reset(profileFrames); // the first frame starts with the loop
     // start game loop
     while (running) {
-        uint64_t nowTime = SDL_GetTicks(); // take time from previous frame to calculate delta
-        float deltaTime = (nowTime - prevTime) / 1000.0f; // convert to seconds from ms
+        const uint64_t paceStart = SDL_GetPerformanceCounter();
+        pacer.wait(); // in target mode, before the events so they are as fresh as they can be
+        gs.profiler.lap(PHASE_PACE, paceStart);
+        uint64_t nowTime = SDL_GetTicksNS(); // take time from previous frame to calculate delta
+        uint64_t frameNS = nowTime - prevTime;
+        float deltaTime = frameNS / static_cast<float>(SDL_NS_PER_SECOND); // convert to seconds from ns
+        prevTime = nowTime;
+        uint64_t lap = SDL_GetPerformanceCounter(); // profiler phases of this frame, back to back
         SDL_Event event { 0 };
         while (SDL_PollEvent(&event)) {
             switch (event.type) {
@@ -201,100 +780,218 @@ int main(int argc, char** argv) { // SDL needs to hijack main to do stuff; inclu
                 }
                 case SDL_EVENT_KEY_DOWN:
                 {
-                    handleKeyInput(state, gs, gs.player(), event.key.scancode, true);
+                    if (event.key.scancode == SDL_SCANCODE_K) {
+                        pressed |= INPUT_JUMP;
+                    }
+                    if (!event.key.repeat && isGameKey(event.key.scancode)) {
+                        latency.event(event.key.timestamp);
+                    }
+                    break;
+                }
+                case SDL_EVENT_RENDER_TARGETS_RESET:
+                {
+                    // target contents were lost, chunks get baked again as they come into view
+                    gs.backChunks.release();
+                    gs.frontChunks.release();
+                    break;
+                }
+                case SDL_EVENT_RENDER_DEVICE_RESET:
+                {
+                    // every texture was lost, the atlas and backgrounds are uploaded again before the chunks bake from them
+                    gs.backChunks.release();
+                    gs.frontChunks.release();
+                    res.unload();
+                    res.load(state, l);
                     break;
                 }
                 case SDL_EVENT_KEY_UP:
                 {
-                    handleKeyInput(state, gs, gs.player(), event.key.scancode, false);
                     if (event.key.scancode == SDL_SCANCODE_F12) {
                         gs.debugMode = !gs.debugMode;
+                    } else if (event.key.scancode == SDL_SCANCODE_F8 && captureLeft == 0) {
+                        capture.begin(state.logW, state.logH);
+                        captureLeft = captureFrames;
+                    } else if ((recordPath || net) && (event.key.scancode == SDL_SCANCODE_F5 || event.key.scancode == SDL_SCANCODE_F9)) {
+                        SDL_Log("Can't save or load while recording or in a rollback session");
+                    } else if (event.key.scancode == SDL_SCANCODE_F5) {
+                        captureSnapshot(gs, quickSave);
+                    } else if (event.key.scancode == SDL_SCANCODE_F9 && !quickSave.empty() &&
+                               !restoreSnapshot(state, gs, quickSave)) {
+                        SDL_Log("Couldn't load the quick save, restarting the level");
+                        restartLevel(state, gs);
                     }
                     break;
                 }
             }
         }
+        gs.profiler.lap(PHASE_EVENTS, lap);
+        const uint8_t held = heldInput(state.keys); // once per frame, every tick of the frame sees the same
+        const bool rewinding = state.keys[SDL_SCANCODE_R] && !recordPath && !net; // a recording or the other side can't follow a jump back
 
-        // update objs
-        for (auto &layer : gs.layers) {
-            for (GameObject &obj : layer) {
-                update(state, gs, res, obj, deltaTime);
+        if (tickNS) {
+            // fixed rate simulation, run as many whole ticks as the elapsed time covers
+            accumulator += frameNS;
+            int steps = 0;
+            while (accumulator >= tickNS && steps < MAX_CATCHUP_STEPS) {
+                const uint8_t input = held | pressed;
+                pressed = 0; // presses go to the first tick only
+                bool advanced = true;
+                if (rewinding) {
+                    rewindTick(state, gs);
+                } else if (net) {
+                    // both sides in turn, the other one walks the stress pattern
+                    const float tickSeconds = tickNS / static_cast<float>(SDL_NS_PER_SECOND);
+                    net->link.setTime(SDL_GetTicksNS());
+                    advanced = netTick(state, net->local, res, tickSeconds, input, true);
+                    netTick(state, net->remote, res, tickSeconds, stressInput(net->remote.tick, tickRate), true);
+                    if (net->local.desynced || net->remote.desynced) {
+                        SDL_Log("Rollback session over, player 2 stands still from here");
+                        net.reset();
+                    }
+                } else {
+                    if (recordPath) {
+                        recording.ticks.push_back(input);
+                    }
+                    stepSimulation(state, gs, res, tickNS / static_cast<float>(SDL_NS_PER_SECOND), input);
+                    keepRewindSnapshot(gs);
+                }
+                if (advanced) {
+                    latency.tick();
+                } else { // stalled waiting on the other side, the press goes to the next tick that runs
+                    pressed |= input & INPUT_JUMP;
+                }
+                accumulator -= tickNS;
+                steps++;
             }
+            if (accumulator >= tickNS) { // stalled too long, drop the backlog instead of spiralling
+                accumulator %= tickNS;
+            }
+            gs.interpAlpha = accumulator / static_cast<float>(tickNS);
+        } else {
+            if (rewinding) {
+                rewindTick(state, gs);
+            } else {
+                stepSimulation(state, gs, res, deltaTime, held | pressed);
+                keepRewindSnapshot(gs);
+            }
+            pressed = 0;
+            latency.tick();
+            gs.interpAlpha = 1;
         }
-        // update bullets
-        for (GameObject &bullet : gs.bullets) {
-            update(state, gs, res, bullet, deltaTime);
-        }
-        // used for camera system
-        gs.mapViewport.x = (gs.player().pos.x + TILE_SIZE / 2) - (gs.mapViewport.w / 2); 
+        gs.drawViewport = gs.mapViewport;
+        gs.drawViewport.x = glm::mix(gs.prevViewportX, gs.mapViewport.x, gs.interpAlpha);
         //draw stuff
+        lap = SDL_GetPerformanceCounter();
+        RenderCapture *recordTo = captureLeft > 0 ? &capture : nullptr; // the debug overlay is left out
         SDL_SetRenderDrawColor(state.renderer, 20, 10, 30, 255);
         SDL_RenderClear(state.renderer);
-
-        // draw background
-        SDL_RenderTexture(state.renderer, res.texBg1, nullptr, nullptr);
-        drawParallaxBackground(state.renderer, res.texBg4, gs.player().vel.x, gs.bg4Scroll, 0.075f, deltaTime);
-        drawParallaxBackground(state.renderer, res.texBg3, gs.player().vel.x, gs.bg3Scroll, 0.15f, deltaTime);
-        drawParallaxBackground(state.renderer, res.texBg2, gs.player().vel.x, gs.bg2Scroll, 0.3f, deltaTime);
-
-        // draw bg tiles
-        for (GameObject &obj : gs.bgTiles) {
-            SDL_FRect dst {
-                .x = obj.pos.x - gs.mapViewport.x,
-                .y = obj.pos.y,
-                .w = static_cast<float>(obj.texture->w),
-                .h = static_cast<float>(obj.texture->h)
-            };
-            SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+        if (recordTo) {
+            recordTo->clear(state.renderer);
         }
 
-        // draw objs
-        for (auto &layer : gs.layers) {
-            for (GameObject &obj : layer) {
-                drawObject(state, gs, obj, TILE_SIZE, TILE_SIZE, deltaTime);
-            }
+        // queue every sprite, the batch sorts them by layer so the order here doesn't matter
+        const SDL_FRect screen { .x = 0, .y = 0, .w = static_cast<float>(state.logW), .h = static_cast<float>(state.logH) };
+        batch.draw(LAYER_SKY, res.texBg1, nullptr, screen);
+        drawParallaxBackground(batch, LAYER_BG_FAR, res.texBg4, gs.player().vel.x, gs.bg4Scroll, 0.075f, deltaTime);
+        drawParallaxBackground(batch, LAYER_BG_MID, res.texBg3, gs.player().vel.x, gs.bg3Scroll, 0.15f, deltaTime);
+        drawParallaxBackground(batch, LAYER_BG_NEAR, res.texBg2, gs.player().vel.x, gs.bg2Scroll, 0.3f, deltaTime);
+        gs.backChunks.draw(batch, LAYER_TILES, gs.drawViewport);
+        gs.frontChunks.draw(batch, LAYER_FG_TILES, gs.drawViewport);
+        lap = gs.profiler.lap(PHASE_DRAW_WORLD, lap);
+        cullSprites(gs);
+        for (int i : gs.visibleCharacters) {
+            drawObject(gs, res, batch, LAYER_CHARACTERS, gs.characters[i], TILE_SIZE, TILE_SIZE, deltaTime);
         }
-
-        // draw bullets
-        for (GameObject &bullet : gs.bullets) {
-            if (bullet.data.bullet.state != BulletState::inactive) {
-                drawObject(state, gs, bullet, bullet.collider.w, bullet.collider.h, deltaTime);
-            }
-        }
-
-        // draw fg tiles
-        for (GameObject &obj : gs.fgTiles) {
-            SDL_FRect dst {
-                .x = obj.pos.x - gs.mapViewport.x,
-                .y = obj.pos.y,
-                .w = static_cast<float>(obj.texture->w),
-                .h = static_cast<float>(obj.texture->h)
-            };
-            SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+        for (int i : gs.visibleBullets) {
+            Entity bullet = gs.bullets[i];
+            drawObject(gs, res, batch, LAYER_BULLETS, bullet, bullet.collider.w, bullet.collider.h, deltaTime);
         }
+        lap = gs.profiler.lap(PHASE_DRAW_SPRITES, lap);
+        batch.flush(state.renderer, recordTo);
+        lap = gs.profiler.lap(PHASE_FLUSH, lap);
+        // effects live in frame time, not ticks, and go on top of everything
+        gs.particles.update(deltaTime, GRAVITY);
+        gs.particles.draw(state.renderer, gs.drawViewport, recordTo);
+        lap = gs.profiler.lap(PHASE_PARTICLES, lap);
 
         if (gs.debugMode) {
+            // colliders on top of the sprites
+            drawTileColliders(state, gs, gs.tiles);
+            for (int i : gs.visibleCharacters) {
+                drawCollider(state, gs, gs.characters[i]);
+            }
+            for (int i : gs.visibleBullets) {
+                drawCollider(state, gs, gs.bullets[i]);
+            }
         // debug info
             SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
             SDL_RenderDebugText(state.renderer, 5, 5,
                             std::format("State: {}, Bullet: {}, Grounded: {}", 
-                            static_cast<int>(gs.player().data.player.state), gs.bullets.size(), gs.player().grounded).c_str());
+                            static_cast<int>(gs.player().obj.data.player.state), gs.bullets.size(), static_cast<bool>(gs.player().grounded)).c_str());
+            SDL_RenderDebugText(state.renderer, 5, 15,
+                            std::format("Candidate pairs: {}, Hits: {}", gs.candidatePairs, gs.collisionHits).c_str());
+            SDL_RenderDebugText(state.renderer, 5, 25,
+                            std::format("Draw calls: {}, Sprites: {}, Particles: {}", batch.getDrawCalls(), batch.getQuadCount(), gs.particles.size()).c_str());
+            SDL_RenderDebugText(state.renderer, 5, 35,
+                            std::format("Culled characters: {}/{}, bullets: {}/{}",
+                            gs.characters.size() - gs.visibleCharacters.size(), gs.characters.size(),
+                            gs.bullets.size() - gs.visibleBullets.size(), gs.bullets.size()).c_str());
+            SDL_RenderDebugText(state.renderer, 5, 45,
+                            std::format("Restarts: {}, last {:.3f} ms", gs.restarts, gs.restartMS).c_str());
+            SDL_RenderDebugText(state.renderer, 5, 55,
+                            std::format("Rewind: {} snapshots, {} KB, capture {:.3f} ms", gs.rewind.size(),
+                            gs.rewind.bytes() / 1024, gs.snapshotMS).c_str());
+            if (net) {
+                const NetPeer &peer = net->local;
+                SDL_RenderDebugText(state.renderer, 5, 65,
+                                std::format("Rollback: depth {} (max {}), resim {:.3f} ms, {} rollbacks, {} stalls, {} ticks ahead",
+                                peer.lastDepth, peer.maxDepth, peer.lastResimMS, peer.rollbacks, peer.stalls,
+                                peer.tick - peer.inputs.getConfirmed(1)).c_str());
+            }
+            SDL_RenderDebugText(state.renderer, 5, 75,
+                            std::format("Pacing: {}{}, input to present p50 {:.1f} ms, p99 {:.1f} ms ({} presses)", pacer.getName(),
+                            pacer.getMode() == PacingMode::target ? std::format(" {} fps", pacer.getFPS()) : "",
+                            latency.percentileMS(0.5), latency.percentileMS(0.99), latency.getCount()).c_str());
+            drawProfiler(state, gs);
         }
+        lap = gs.profiler.lap(PHASE_DEBUG, lap);
         //swap buffers and present
         SDL_RenderPresent(state.renderer);
+        latency.present(SDL_GetTicksNS());
+        if (recordTo) {
+            recordTo->endFrame();
+            const char *path = capturePath ? capturePath : DEFAULT_CAPTURE_PATH;
+            if (--captureLeft == 0 && !capture.save(path)) {
+                SDL_Log("Couldn't write render capture %s", path);
+            } else if (captureLeft == 0) {
+                SDL_Log("Captured %u frames, %zu commands to %s", capture.frames, capture.commands.size(), path);
+            }
+        }
+        gs.profiler.lap(PHASE_PRESENT, lap);
+        gs.profiler.endFrame();
         prevTime = nowTime;
-        /*if (dead) {
-            goto main_loop;
-            dead = false;
-        }*/
     }
 
+    if (profileCSV && !gs.profiler.writeCSV(profileCSV)) {
+        SDL_Log("Couldn't write profile %s", profileCSV);
+    }
+    if (latency.getCount() > 0) {
+        latency.print(stdout, pacer.getName());
+    }
+    if (recordPath) {
+        recording.finalChecksum = worldChecksum(gs);
+        if (!recording.save(recordPath)) {
+            SDL_Log("Couldn't write recording %s", recordPath);
+        }
+    }
+    gs.backChunks.release();
+    gs.frontChunks.release();
     res.unload();
     cleanup(state);
     return 0;
 }
 
-bool initialize(SDLState &state) {
+bool initialize(SDLState &state, bool vsync) {
     bool initSuccess = true;
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Error Initializing SDL3", nullptr);
@@ -314,7 +1011,7 @@ bool initialize(SDLState &state) {
         initSuccess = false;
     }
 
-    SDL_SetRenderVSync(state.renderer, 1); // turn this SHIT off
+    SDL_SetRenderVSync(state.renderer, vsync ? 1 : SDL_RENDERER_VSYNC_DISABLED); // see FramePacer for the other modes
 
     // configure presentation
     SDL_SetRenderLogicalPresentation(state.renderer, state.logW, state.logH, SDL_LOGICAL_PRESENTATION_LETTERBOX);
@@ -327,130 +1024,307 @@ void cleanup(SDLState &state) {
     SDL_Quit();
 }
 
-void drawObject(const SDLState &state, GameState &gs, GameObject &obj, float width, float height, float deltaTime) {
-        float srcX = obj.curAnimation != -1 
-                     ? obj.animations[obj.curAnimation].currentFrame() * width 
+void drawObject(GameState &gs, const Resources &res, SpriteBatch &batch, int layer, Entity ent, float width, float height, float deltaTime) {
+        GameObject &obj = ent.obj;
+        float srcX = obj.anim.clip != -1 
+                     ? obj.anim.currentFrame(res.animations[obj.anim.clip]) * width 
                      : (obj.spriteFrame - 1) * width;
-        SDL_FRect src {
-            .x = srcX,
-            .y = 0,
-            .w = width,
-            .h = height
-        };
+        const Sprite &sprite = res.sprites[obj.sprite];
+        const SDL_FRect src = sprite.sub(srcX, 0, width, height); // frame inside the atlas region
 
+        // draw between the last two simulated positions
+        const glm::vec2 drawPos = glm::mix(ent.prevPos, ent.pos, gs.interpAlpha);
         SDL_FRect dst {
-            .x = obj.pos.x - gs.mapViewport.x,
-            .y = obj.pos.y,
+            .x = drawPos.x - gs.drawViewport.x,
+            .y = drawPos.y,
             .w = width,
             .h = height
         };
         SDL_FlipMode flipMode = obj.dir == -1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
         if (!obj.shouldFlash) {
-            SDL_RenderTextureRotated(state.renderer, obj.texture, &src, &dst, 0, nullptr, flipMode); // src is for sprite stripping, dest is for where sprite should be drawn
+            batch.draw(layer, sprite.texture, &src, dst, flipMode); // src is for sprite stripping, dest is for where sprite should be drawn
         } else {
-            // flash with white tint
-            SDL_SetTextureColorModFloat(obj.texture, 2.5f, 2.5f, 2.5f);  
-            SDL_RenderTextureRotated(state.renderer, obj.texture, &src, &dst, 0, nullptr, flipMode);
-            SDL_SetTextureColorModFloat(obj.texture, 1.0f, 1.0f, 1.0f);
+            // flash with white tint, carried in the vertex colors so it doesn't break the batch
+            batch.draw(layer, sprite.texture, &src, dst, flipMode, SDL_FColor { 2.5f, 2.5f, 2.5f, 1.0f });
             if (obj.flashTimer.step(deltaTime)) {
                 obj.shouldFlash = false;
             }
         }
+}
 
+// collider and ground sensor, drawn straight to the renderer after the batch
+void drawCollider(const SDLState &state, const GameState &gs, Entity ent) {
+        const glm::vec2 drawPos = glm::mix(ent.prevPos, ent.pos, gs.interpAlpha);
+        SDL_FRect rectA {
+            .x = drawPos.x + ent.collider.x - gs.drawViewport.x, 
+            .y = drawPos.y + ent.collider.y,
+            .w = ent.collider.w, 
+            .h = ent.collider.h
+        };
+        SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_BLEND);
 
-        if (gs.debugMode) {
-            SDL_FRect rectA {
-                .x = obj.pos.x + obj.collider.x - gs.mapViewport.x, 
-                .y = obj.pos.y + obj.collider.y,
-                .w = obj.collider.w, 
-                .h = obj.collider.h
-            };
-            SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(state.renderer, 255, 0, 0, 150);
+        SDL_RenderFillRect(state.renderer, &rectA);
+        SDL_FRect sensor{
+            .x = drawPos.x + ent.collider.x - gs.drawViewport.x,
+            .y = drawPos.y + ent.collider.y + ent.collider.h,
+            .w = ent.collider.w, 
+            .h = 1
+        };
+        SDL_SetRenderDrawColor(state.renderer, 0, 0, 255, 150);
+        SDL_RenderFillRect(state.renderer, &sensor);
 
-            SDL_SetRenderDrawColor(state.renderer, 255, 0, 0, 150);
-            SDL_RenderFillRect(state.renderer, &rectA);
-            SDL_FRect sensor{
-			    .x = obj.pos.x + obj.collider.x - gs.mapViewport.x,
-			    .y = obj.pos.y + obj.collider.y + obj.collider.h,
-			    .w = obj.collider.w, 
-                .h = 1
-		    };
-		    SDL_SetRenderDrawColor(state.renderer, 0, 0, 255, 150);
-		    SDL_RenderFillRect(state.renderer, &sensor);
+        SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_NONE);
+}
 
-            SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_NONE);
+// one fixed step of the whole world, inputs has what each of the gs.playerCount players holds
+// and pressed this tick (INPUT_ bits)
+void stepSimulation(const SDLState &state, GameState &gs, Resources &res, float deltaTime, const uint8_t *inputs) {
+    uint64_t lap = SDL_GetPerformanceCounter();
+    std::copy(inputs, inputs + gs.playerCount, gs.inputs);
+    for (int slot = 0; slot < gs.playerCount; slot++) {
+        if (gs.inputs[slot] & INPUT_JUMP) {
+            handleKeyInput(state, gs, gs.player(slot), SDL_SCANCODE_K, true);
+        }
+    }
+    if (streamWorld(state, gs, res)) { // follow the camera of the last tick
+        buildBroadphase(gs); // the AI queries it before the collision phase rebuilds it
+    }
+    lap = gs.profiler.lap(PHASE_STREAM, lap);
+    // remember where everything was so drawing can interpolate
+    gs.characters.savePositions();
+    gs.bullets.savePositions();
+    gs.prevViewportX = gs.mapViewport.x;
+
+    // type specific logic, picks each entity's steering. the players go first on their own since
+    // they read input, roll random numbers and spawn bullets, everything else only touches itself
+    for (int slot = 0; slot < gs.playerCount; slot++) {
+        update(state, gs, res, gs.player(slot), deltaTime);
+    }
+    scheduleAI(gs);
+    gs.jobs.parallelFor(gs.characters.size(), JOB_GRAIN, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            GameObject &obj = gs.characters.objects[i];
+            if (obj.type == ObjectType::player) {
+                continue;
+            }
+            if (obj.type != ObjectType::enemy) {
+                update(state, gs, res, gs.characters[i], deltaTime);
+                continue;
+            }
+            // enemies far from the camera think less often, staggered by index so every tick
+            // takes a similar share. between updates they keep their steering
+            EnemyData &d = obj.data.enemy;
+            if ((gs.tick + i) % gs.aiPeriod[i] != 0) {
+                d.skippedTime += deltaTime;
+                continue;
+            }
+            const float catchUp = d.skippedTime;
+            d.skippedTime = 0;
+            update(state, gs, res, gs.characters[i], deltaTime + catchUp); // timers and animation don't lose time
         }
+    });
+    lap = gs.profiler.lap(PHASE_UPDATE, lap);
+    gs.jobs.parallelFor(gs.bullets.size(), JOB_GRAIN, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            update(state, gs, res, gs.bullets[i], deltaTime);
+        }
+    });
+    releaseBullets(gs); // the rest of the tick only sees live bullets
+    lap = gs.profiler.lap(PHASE_BULLETS, lap);
+    // physics for every entity
+    gs.jobs.parallelFor(gs.characters.size(), JOB_GRAIN, [&](size_t begin, size_t end, int) {
+        gs.characters.integrate(deltaTime, GRAVITY, begin, end);
+    });
+    gs.jobs.parallelFor(gs.bullets.size(), JOB_GRAIN, [&](size_t begin, size_t end, int) {
+        gs.bullets.integrate(deltaTime, GRAVITY, begin, end);
+    });
+    lap = gs.profiler.lap(PHASE_INTEGRATE, lap);
+    // collision, found in parallel and applied in entity order so the result never depends on
+    // how the work was split between threads
+    buildBroadphase(gs);
+    const size_t characterCount = gs.characters.size();
+    gs.contactLists.resize(gs.jobs.getThreadCount());
+    for (ContactList &list : gs.contactLists) {
+        list.contacts.clear();
+    }
+    gs.contactSpans.resize(characterCount + gs.bullets.size());
+    gs.jobs.parallelFor(gs.contactSpans.size(), JOB_GRAIN / 4, [&](size_t begin, size_t end, int thread) {
+        for (size_t i = begin; i < end; i++) {
+            if (i < characterCount) {
+                detectContacts(gs, gs.characters, i, static_cast<int>(i), thread, gs.contactLists[thread], gs.contactSpans[i]);
+            } else {
+                detectContacts(gs, gs.bullets, i - characterCount, -1, thread, gs.contactLists[thread], gs.contactSpans[i]);
+            }
+        }
+    });
+    for (size_t i = 0; i < characterCount; i++) {
+        resolveContacts(state, gs, res, gs.characters[i], gs.contactSpans[i], deltaTime);
+    }
+    for (size_t i = 0; i < gs.bullets.size(); i++) {
+        resolveContacts(state, gs, res, gs.bullets[i], gs.contactSpans[characterCount + i], deltaTime);
+    }
+    gs.profiler.lap(PHASE_COLLISION, lap);
+    gs.tick++;
+    // used for camera system
+    gs.mapViewport.x = cameraX(gs);
+    if (gs.playerCount > 1) { // players share the screen, nobody walks off it
+        for (int slot = 0; slot < gs.playerCount; slot++) {
+            Entity p = gs.player(slot);
+            p.pos.x = std::clamp(p.pos.x, gs.mapViewport.x, gs.mapViewport.x + gs.mapViewport.w - TILE_SIZE);
+        }
+    }
+    if (gs.restartPending) {
+        const uint64_t start = SDL_GetPerformanceCounter();
+        restartLevel(state, gs);
+        gs.restartMS = gs.profiler.toMS(SDL_GetPerformanceCounter() - start);
+        gs.restarts++;
+    }
 }
 
-void update(const SDLState &state, GameState &gs, Resources &res, GameObject &obj, float deltaTime) {
-    // update animation
-    if (obj.curAnimation != -1) {
-        obj.animations[obj.curAnimation].step(deltaTime);
+// a single player's tick
+void stepSimulation(const SDLState &state, GameState &gs, Resources &res, float deltaTime, uint8_t input) {
+    const uint8_t inputs[MAX_PLAYERS] = { input };
+    stepSimulation(state, gs, res, deltaTime, inputs);
+}
+
+// left edge of the camera centered between the players that are still alive, or all of them once none is
+float cameraX(GameState &gs) {
+    const bool allDead = playersDead(gs);
+    float sum = 0;
+    int count = 0;
+    for (int slot = 0; slot < gs.playerCount; slot++) {
+        Entity p = gs.player(slot);
+        if (allDead || p.obj.data.player.state != PlayerState::dead) {
+            sum += p.pos.x;
+            count++;
+        }
     }
-    if (obj.dynamic && !obj.grounded) {
-        obj.vel += glm::vec2(0, 700) * deltaTime; // gravity
-        //printf("x=%d, y=%d\n", obj.pos.x, obj.pos.y);
+    return (sum / count + TILE_SIZE / 2) - (gs.mapViewport.w / 2);
+}
+
+bool playersDead(GameState &gs) {
+    for (int slot = 0; slot < gs.playerCount; slot++) {
+        if (gs.player(slot).obj.data.player.state != PlayerState::dead) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void drawTileColliders(const SDLState &state, const GameState &gs, const TileMap &tiles) {
+    SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(state.renderer, 255, 0, 0, 150);
+    tiles.forEachTile(gs.drawViewport, 0, [&](int r, int c, uint8_t) {
+        SDL_FRect dst = tiles.cellRect(r, c);
+        dst.x -= gs.drawViewport.x;
+        SDL_RenderFillRect(state.renderer, &dst);
+    });
+    SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_NONE);
+}
+
+// F12 overlay: frame times of the kept frames stacked by phase along the bottom of the screen,
+// newest on the right, and p50 / p99 per phase. grey is time no phase accounts for
+void drawProfiler(const SDLState &state, GameState &gs) {
+    FrameProfiler &profiler = gs.profiler;
+    const float bottom = state.logH - 5.0f;
+    const float pixelsPerMS = 100 / 33.3f; // two 60 Hz frames fill 100 pixels
+    const size_t frames = std::min(profiler.getFrameCount(), static_cast<size_t>(state.logW - 10));
+    std::vector<float> stacked(frames, 0);
+    std::vector<SDL_FRect> bars(frames);
+    const auto drawBars = [&](SDL_Color color, const auto &msOf) {
+        for (size_t age = 0; age < frames; age++) {
+            const float h = static_cast<float>(msOf(profiler.getFrame(age))) * pixelsPerMS;
+            stacked[age] += h;
+            bars[age] = SDL_FRect { .x = state.logW - 6.0f - age, .y = bottom - stacked[age], .w = 1, .h = h };
+        }
+        SDL_SetRenderDrawColor(state.renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(state.renderer, bars.data(), static_cast<int>(frames));
+    };
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        drawBars(PHASE_COLORS[phase], [&](const FrameProfiler::Frame &f) { return profiler.toMS(f.phases[phase]); });
+    }
+    drawBars(SDL_Color { 90, 90, 90, 255 }, [&](const FrameProfiler::Frame &f) {
+        uint64_t measured = 0;
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            measured += f.phases[phase];
+        }
+        return profiler.toMS(f.total > measured ? f.total - measured : 0);
+    });
+    SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+    const float frame60 = bottom - 16.7f * pixelsPerMS;
+    SDL_RenderLine(state.renderer, 5, frame60, state.logW - 5.0f, frame60);
+
+    float y = 90;
+    SDL_RenderDebugText(state.renderer, 5, y, std::format("frame p50 {:.2f} ms, p99 {:.2f} ms",
+                        profiler.percentileMS(-1, 0.5), profiler.percentileMS(-1, 0.99)).c_str());
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        y += 10;
+        const SDL_Color &c = PHASE_COLORS[phase];
+        SDL_SetRenderDrawColor(state.renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderDebugText(state.renderer, 5, y, std::format("{:<13} p50 {:.2f} ms, p99 {:.2f} ms", profiler.getName(phase),
+                            profiler.percentileMS(phase, 0.5), profiler.percentileMS(phase, 0.99)).c_str());
+    }
+}
+
+// type specific logic, movement itself happens in EntityStore::integrate
+void update(const SDLState &state, GameState &gs, Resources &res, Entity ent, float deltaTime) {
+    GameObject &obj = ent.obj;
+    // update animation
+    if (obj.anim.clip != -1) {
+        obj.anim.step(res.animations[obj.anim.clip], deltaTime);
     }
     float currentDirection = 0;
     if (obj.type == ObjectType::player) {
+        const uint8_t input = gs.inputs[obj.data.player.slot];
         if (obj.data.player.state != PlayerState::dead) {
-            if (state.keys[SDL_SCANCODE_A]) {
+            if (input & INPUT_LEFT) {
                 currentDirection += -1;
             }
-            if (state.keys[SDL_SCANCODE_D]) {
+            if (input & INPUT_RIGHT) {
                 currentDirection += 1;
             }
             Timer &weaponTimer = obj.data.player.weaponTimer;
             weaponTimer.step(deltaTime);
-            const auto handleShooting = [&state, &gs, &res, &obj, &weaponTimer]() {
-                if (state.keys[SDL_SCANCODE_J]) {
+            const auto handleShooting = [&state, &gs, &res, &ent, &obj, &weaponTimer, input]() {
+                if (input & INPUT_SHOOT) {
                     // bullets!
                      // in 2.5 hour video, go to 1:54:19 if you want to sync up shooting sprites with animations for running
                     if (weaponTimer.isTimeOut()) {
                         /*if (obj.data.player.state == PlayerState::idle) {
-                            obj.texture = res.texShoot;
-                            obj.curAnimation = res.ANIM_PLAYER_SHOOT;
+                            obj.sprite = res.SPR_SHOOT;
+                            obj.anim.play(res.ANIM_PLAYER_SHOOT);
                         }*/
                         weaponTimer.reset();
                         GameObject bullet;
+                        Body body;
                         bullet.data.bullet = BulletData();
                         bullet.type = ObjectType::bullet;
-                        bullet.dir = gs.player().dir;
-                        bullet.texture = res.texBullet;
-                        bullet.curAnimation = res.ANIM_BULLET_MOVING;
-                        bullet.collider = SDL_FRect {
+                        bullet.dir = obj.dir;
+                        bullet.sprite = res.SPR_BULLET;
+                        bullet.anim.play(res.ANIM_BULLET_MOVING);
+                        body.collider = SDL_FRect {
                             .x = 0,
                             .y = 0,
-                            .w = static_cast<float>(res.texBullet->h),
-                            .h = static_cast<float>(res.texBullet->h)
+                            .w = res.BULLET_SIZE,
+                            .h = res.BULLET_SIZE
                         };
                         const float left = 0;
                         const float right = 24;
                         const float t = (obj.dir + 1) / 2.0f; // results in 0 to 1
                         const float xOffset = left + right * t; // LERP between left and right
                         const float yVariation = 40;
-                        const float yVelocity = SDL_rand(yVariation) - yVariation / 2.0f;
-                        bullet.vel = glm::vec2(
-                        obj.vel.x + 300.0f * obj.dir, yVelocity);
-                        //printf("bullet.vel.x = %f\n", bullet.vel.x);
-                        bullet.maxSpeedX = 1000.0f;
-                        bullet.animations = res.bulletAnims;
-                        bullet.pos = glm::vec2( 
-                            obj.pos.x + xOffset,
-                            obj.pos.y + TILE_SIZE / 2 + 1
+                        const float yVelocity = SDL_rand_r(&gs.rng, yVariation) - yVariation / 2.0f;
+                        body.vel = glm::vec2(
+                        ent.vel.x + 300.0f * obj.dir, yVelocity);
+                        //printf("bullet.vel.x = %f\n", body.vel.x);
+                        body.maxSpeedX = 1000.0f;
+                        body.pos = glm::vec2( 
+                            ent.pos.x + xOffset,
+                            ent.pos.y + TILE_SIZE / 2 + 1
                         );
-                        // try to reuse old inactive bullets
-                        bool foundInactive = false;
-                        for (int i = 0; i < gs.bullets.size() && !foundInactive; i++) {
-                            if (gs.bullets[i].data.bullet.state == BulletState::inactive) {
-                                foundInactive = true;
-                                gs.bullets[i] = bullet;
-                            }
-                        }
-                        // otherwise push new bullet
-                        if (!foundInactive) {
-                            gs.bullets.push_back(bullet);
-                        }
+                        spawnBullet(gs, body, bullet);
+                        gs.particles.emit(body.pos, glm::vec2(obj.dir, 0), BURST_MUZZLE);
                     }
                 }
             };
@@ -461,72 +1335,72 @@ void update(const SDLState &state, GameState &gs, Resources &res, GameObject &ob
                         obj.data.player.state = PlayerState::running;
                     }
                     else {
-                        if (obj.vel.x) { // slow player down when idle
-                            const float factor = obj.vel.x > 0 ? -1.5f : 1.5f;
-                            float amount = factor * obj.acc.x * deltaTime;
-                            if (std::abs(obj.vel.x) < std::abs(amount)) {
-                                obj.vel.x = 0;
+                        if (ent.vel.x) { // slow player down when idle
+                            const float factor = ent.vel.x > 0 ? -1.5f : 1.5f;
+                            float amount = factor * ent.acc.x * deltaTime;
+                            if (std::abs(ent.vel.x) < std::abs(amount)) {
+                                ent.vel.x = 0;
                             }
                             else {
-                                obj.vel.x += amount;
+                                ent.vel.x += amount;
                             }
                         }
                     }
-                    obj.texture = res.texIdle;
-                    obj.curAnimation = res.ANIM_PLAYER_IDLE;
+                    obj.sprite = res.SPR_IDLE;
+                    obj.anim.play(res.ANIM_PLAYER_IDLE);
                     handleShooting();
                     break;
                 }
                 case PlayerState::running:
                 {
-                    if (!currentDirection && obj.grounded) { // if not moving return to idle
+                    if (!currentDirection && ent.grounded) { // if not moving return to idle
                         obj.data.player.state = PlayerState::idle;
                     }
-                    if (obj.vel.x * obj.dir < 0 && obj.grounded) { // moving in different direction of vel, sliding
-                        obj.texture = res.texSlide;
-                        obj.curAnimation = res.ANIM_PLAYER_SLIDE;
+                    if (ent.vel.x * obj.dir < 0 && ent.grounded) { // moving in different direction of vel, sliding
+                        obj.sprite = res.SPR_SLIDE;
+                        obj.anim.play(res.ANIM_PLAYER_SLIDE);
                     } else {
-                        obj.texture = res.texRun;
-                        obj.curAnimation = res.ANIM_PLAYER_RUN;
+                        obj.sprite = res.SPR_RUN;
+                        obj.anim.play(res.ANIM_PLAYER_RUN);
                     }
                     handleShooting();
                     break;
                 }
                 case PlayerState::jumping:
                 {
-                    obj.texture = res.texJump;
-                    obj.curAnimation = res.ANIM_PLAYER_JUMP;
+                    obj.sprite = res.SPR_JUMP;
+                    obj.anim.play(res.ANIM_PLAYER_JUMP);
                     handleShooting();
                     break;
                 }
             }
-            if (obj.pos.y - gs.mapViewport.y > state.logH) {
+            if (ent.pos.y - gs.mapViewport.y > state.logH) {
                 obj.data.player.state = PlayerState::dead; // die if you fall off
-                obj.vel.x = 0;
+                ent.vel.x = 0;
             }
-            //printf("Player x = %f, Player y = %f\n", obj.pos.x, obj.pos.y);
-        } else { // player is dead, reset map
+            //printf("Player x = %f, Player y = %f\n", ent.pos.x, ent.pos.y);
+        } else { // player is dead, reset map once everybody is
             Timer &deathTimer = obj.data.player.deathTimer;
             deathTimer.step(deltaTime);
-            if (deathTimer.isTimeOut()) {
-                running = false; // exit program
+            if (deathTimer.isTimeOut() && playersDead(gs)) {
+                gs.restartPending = true; // once the tick is over, see stepSimulation
             }
         }
         
     } else if (obj.type == ObjectType::bullet) {
         switch (obj.data.bullet.state) {
             case BulletState::moving: {
-                if (obj.pos.x - gs.mapViewport.x < 0 || // left side
-                    obj.pos.x - gs.mapViewport.x > state.logW || // right side
-                    obj.pos.y - gs.mapViewport.y < 0 || // up
-                    obj.pos.y - gs.mapViewport.y > state.logH) // down
+                if (ent.pos.x - gs.mapViewport.x < 0 || // left side
+                    ent.pos.x - gs.mapViewport.x > state.logW || // right side
+                    ent.pos.y - gs.mapViewport.y < 0 || // up
+                    ent.pos.y - gs.mapViewport.y > state.logH) // down
                 { 
                     obj.data.bullet.state = BulletState::inactive;
                 }
                 break;
             }
             case BulletState::colliding: {
-                if (obj.animations[obj.curAnimation].isDone()) {
+                if (obj.anim.done) {
                     obj.data.bullet.state = BulletState::inactive;
                 }
             }
@@ -534,16 +1408,14 @@ void update(const SDLState &state, GameState &gs, Resources &res, GameObject &ob
     } else if (obj.type == ObjectType::enemy) {
         EnemyData &d = obj.data.enemy;
         switch (d.state) {
-            /*case EnemyState::idle: {
-                glm::vec2 playerDir = gs.player().pos - obj.pos;
-                if (glm::length(playerDir) < 100) {
-                    currentDirection = playerDir.x < 0 ? -1 : 1;
-                } else {
-                    obj.acc = glm::vec2(0);
-                    obj.vel.x = 0;
+            case EnemyState::idle: {
+                // go after a player once one comes close, otherwise keep patrolling. who is close
+                // comes from one query around each player in scheduleAI
+                if (d.aware) {
+                    currentDirection = gs.player(d.target).pos.x < ent.pos.x ? -1 : 1; // nothing writes players while enemies update
                 }
                 break;
-            }*/ // this is for proximity based movement, ignore
+            }
             case EnemyState::damaged:
             {
                 if (d.damagedTimer.step(deltaTime)) {
@@ -552,9 +1424,9 @@ void update(const SDLState &state, GameState &gs, Resources &res, GameObject &ob
                 break;
             }
             case EnemyState::dead: {
-                obj.vel.x = 0;
-                if (obj.curAnimation != -1 && obj.animations[obj.curAnimation].isDone()) {
-                    obj.curAnimation = -1;
+                ent.vel.x = 0;
+                if (obj.anim.clip != -1 && obj.anim.done) {
+                    obj.anim.stop();
                     obj.spriteFrame = 1;
                 }
                 break;
@@ -564,129 +1436,258 @@ void update(const SDLState &state, GameState &gs, Resources &res, GameObject &ob
     if (currentDirection) {
         obj.dir = currentDirection;
     }
-    obj.vel += currentDirection * obj.acc * deltaTime;
-    if (std::abs(obj.vel.x) > obj.maxSpeedX) {
-        obj.vel.x = currentDirection * obj.maxSpeedX;
-    }
-    // add vel to pos
-    obj.pos += obj.vel * deltaTime;
-    // collision
-    bool foundGround = false;
-    for (auto &layer : gs.layers) {
-        for (GameObject &objB : layer) {
-            if (&obj != &objB) {
-                checkCollision(state, gs, res, obj, objB, deltaTime);
-                if (objB.type == ObjectType::level) {
-                    // grounded sensor
-                    const float inset = 2.0;
-                    SDL_FRect sensor {
-                        .x = obj.pos.x + obj.collider.x + 1,
-                        .y = obj.pos.y + obj.collider.y + obj.collider.h,
-                        .w = obj.collider.w - inset,
-                        .h = 1
-                    };
-                    SDL_FRect rectB {
-                        .x = objB.pos.x + objB.collider.x,
-                        .y = objB.pos.y + objB.collider.y,
-                        .w = objB.collider.w,
-                        .h = objB.collider.h
-                    };
-                    SDL_FRect rectC { 0 };
-                    if (SDL_GetRectIntersectionFloat(&sensor, &rectB, &rectC)) {
-                        foundGround = true;
-                    }
-                }    
-            }
+    ent.moveDir = currentDirection;
+}
+
+// O(1), takes the next free slot or applies the overflow policy when the pool is full
+void spawnBullet(GameState &gs, const Body &body, const GameObject &bullet) {
+    if (gs.bullets.size() < gs.bulletCap) {
+        gs.bullets.add(body, bullet); // within the reserved capacity, never reallocates
+    } else if (gs.bulletOverflow == PoolOverflow::recycle && gs.bullets.size()) {
+        gs.bulletRecycle %= gs.bullets.size();
+        gs.bullets.set(gs.bulletRecycle++, body, bullet);
+    } else {
+        gs.bulletsDropped++;
+    }
+}
+
+// swap remove every bullet that went inactive this tick so live ones stay packed
+void releaseBullets(GameState &gs) {
+    for (size_t i = 0; i < gs.bullets.size();) {
+        if (gs.bullets.objects[i].data.bullet.state == BulletState::inactive) {
+            gs.bullets.remove(i); // the last bullet moves into i, check it next
+        } else {
+            i++;
+        }
+    }
+}
+
+// broadphase for entity i of store: the solid tiles and the characters it may touch this tick.
+// only reads the world, so it runs for many entities at once. the exact overlap tests wait for
+// resolveContacts since earlier responses move things. gridId is i for a character, -1 otherwise
+void detectContacts(const GameState &gs, const EntityStore &store, size_t i, int gridId, int list, ContactList &out, ContactSpan &span) {
+    // everything the collider passed over this tick, the responses sweep it from the old position
+    const SDL_FRect from = colliderRect(store.prevPos[i], store.collider[i]);
+    const SDL_FRect to = colliderRect(store.pos[i], store.collider[i]);
+    const float x0 = std::min(from.x, to.x), y0 = std::min(from.y, to.y);
+    const SDL_FRect rect {
+        .x = x0,
+        .y = y0,
+        .w = std::max(from.x + from.w, to.x + to.w) - x0,
+        .h = std::max(from.y + from.h, to.y + to.h) - y0
+    };
+    span.list = list;
+    span.begin = static_cast<uint32_t>(out.contacts.size());
+    // pad by a cell, a push out can move the object onto a neighbouring tile
+    gs.tiles.forEachTile(rect, 1, [&](int r, int c, uint8_t) {
+        out.contacts.push_back(Contact { .row = r, .col = c, .other = -1 });
+    });
+    // characters sharing a grid cell. responses move things a little after the grid was built,
+    // so pad the query by a cell
+    const SDL_FRect queryRect {
+        .x = rect.x - TILE_SIZE,
+        .y = rect.y - TILE_SIZE,
+        .w = rect.w + TILE_SIZE * 2,
+        .h = rect.h + TILE_SIZE * 2
+    };
+    gs.grid.query(queryRect, out.candidates, out.query);
+    for (int id : out.candidates) {
+        if (id != gridId) {
+            out.contacts.push_back(Contact { .row = -1, .col = -1, .other = id });
+        }
+    }
+    span.count = static_cast<uint32_t>(out.contacts.size()) - span.begin;
+}
+
+// move obj through the level tiles and resolve its contacts with other objects, then refresh
+// its grounded flag. responses write to both sides of a contact, so this runs on one thread in
+// a fixed order
+void resolveContacts(const SDLState &state, GameState &gs, Resources &res, Entity obj, const ContactSpan &span, float deltaTime) {
+    const std::vector<Contact> &contacts = gs.contactLists[span.list].contacts;
+    const size_t end = span.begin + span.count;
+    size_t k = span.begin;
+    // level tiles come first
+    while (k < end && contacts[k].other == -1) {
+        k++;
+    }
+    sweepTiles(gs, res, obj, contacts.data() + span.begin, k - span.begin);
+    // grounded sensor
+    const float inset = 2.0;
+    SDL_FRect sensor {
+        .x = obj.pos.x + obj.collider.x + 1,
+        .y = obj.pos.y + obj.collider.y + obj.collider.h,
+        .w = obj.collider.w - inset,
+        .h = 1
+    };
+    bool foundGround = gs.tiles.overlapsSolid(sensor);
+    // then characters
+    for (; k < end; k++) {
+        gs.candidatePairs++;
+        if (checkCollision(state, gs, res, obj, gs.characters[contacts[k].other], deltaTime)) {
+            gs.collisionHits++;
         }
     }
     if (obj.grounded != foundGround) { // changing state
         obj.grounded = foundGround;
-        if (foundGround && obj.type == ObjectType::player && obj.data.player.state != PlayerState::dead) {
-            obj.data.player.state = PlayerState::running;
+        if (foundGround && obj.obj.type == ObjectType::player && obj.obj.data.player.state != PlayerState::dead) {
+            obj.obj.data.player.state = PlayerState::running;
         }
     }
 }
 
-void collisionResponse(const SDLState &state, GameState &gs, const Resources &res, 
-                       const SDL_FRect &rectA, const SDL_FRect &rectB, 
-                       const SDL_FRect &rectC, GameObject &a, GameObject &b, float deltaTime) 
-{
-    const auto genericResponse = [&]() {
-        if (rectC.w < rectC.h) { // horizontal col
-            //printf("Horizontal Collision, %f = rectC.w, %f = rectC.h\n", rectC.w, rectC.h);
-            if (a.vel.x > 0) { // going right
-                a.pos.x -= rectC.w;
-            }
-            else if (a.vel.x < 0) { // going left
-                a.pos.x += rectC.w;
-            }
-            if (a.type == ObjectType::enemy) {
-                a.vel.x = -a.vel.x; // turn enemy around when it hits a wall
-                a.dir = -a.dir;
-            } else {
-                a.vel.x = 0;
-            }
-            
-        } 
-        else { // vert col
-            //printf("Vertical Collision, %f = rectC.w, %f = rectC.h\n", rectC.w, rectC.h);
-            if (a.vel.y > 0) { // going down
-                a.pos.y -= rectC.h;
-            }
-            else if (a.vel.y < 0)  { // going up
-                a.pos.y += rectC.h;
+// moves obj from where it was at the start of the tick to where integrate put it. it stops at
+// the first solid tile on the way and slides along it with what is left of the move, so it can't
+// skip a tile however far it goes in one tick
+void sweepTiles(GameState &gs, const Resources &res, Entity obj, const Contact *tiles, size_t count) {
+    const int MAX_SLIDES = 3; // a move can stop at a floor and then at a wall, the third is for corners
+    if (!collidesWithLevel(obj.obj)) { // the dead pass through tiles, they keep the integrated move
+        return;
+    }
+    glm::vec2 move = obj.pos - obj.prevPos;
+    obj.pos = obj.prevPos;
+    for (int slide = 0; slide < MAX_SLIDES && (move.x != 0 || move.y != 0) && collidesWithLevel(obj.obj); slide++) {
+        const SDL_FRect rect = colliderRect(obj.pos, obj.collider);
+        SweepHit first { .time = 1, .normal = glm::vec2(0) };
+        const Contact *hitTile = nullptr;
+        for (size_t k = 0; k < count; k++) {
+            SweepHit hit;
+            gs.candidatePairs++;
+            if (sweepRect(rect, move, gs.tiles.cellRect(tiles[k].row, tiles[k].col), hit) && hit.time < first.time) {
+                first = hit;
+                hitTile = &tiles[k];
             }
-            a.vel.y = 0;
         }
-    };
+        obj.pos += move * first.time;
+        if (!hitTile) {
+            break;
+        }
+        gs.collisionHits++;
+        move *= 1 - first.time;
+        move -= first.normal * glm::dot(move, first.normal); // drop the part going into the tile
+        levelResponse(gs, res, gs.tiles.cellRect(hitTile->row, hitTile->col), first.normal, obj);
+    }
+    // still overlapping means it started the tick inside a tile, another character pushed it there
+    for (size_t k = 0; k < count && collidesWithLevel(obj.obj); k++) {
+        const SDL_FRect rect = colliderRect(obj.pos, obj.collider);
+        const SDL_FRect cell = gs.tiles.cellRect(tiles[k].row, tiles[k].col);
+        if (rectsOverlap(rect, cell)) {
+            gs.collisionHits++;
+            levelResponse(gs, res, cell, pushOutNormal(rect, cell), obj);
+        }
+    }
+}
+
+// stops a against the face of target it ran into, normal points from that face towards a
+void genericResponse(const SDL_FRect &target, glm::vec2 normal, Entity a) {
+    if (normal.x != 0) { // horizontal col
+        a.pos.x = normal.x < 0 ? target.x - a.collider.x - a.collider.w : target.x + target.w - a.collider.x;
+        if (a.obj.type == ObjectType::enemy) {
+            a.vel.x = SDL_fabsf(a.vel.x) * normal.x; // turn enemy around when it hits a wall
+            a.obj.dir = normal.x;
+        } else {
+            a.vel.x = 0;
+        }
+    } 
+    else { // vert col
+        a.pos.y = normal.y < 0 ? target.y - a.collider.y - a.collider.h : target.y + target.h - a.collider.y;
+        a.vel.y = 0;
+    }
+}
+
+// center of obj's collider in the world, where its effects come from
+glm::vec2 colliderCenter(Entity obj) {
+    return obj.pos + glm::vec2(obj.collider.x + obj.collider.w / 2, obj.collider.y + obj.collider.h / 2);
+}
+
+// bullet stops and switches to its hit animation, sparks fly back off the face it hit
+void bulletImpact(GameState &gs, const Resources &res, const SDL_FRect &target, glm::vec2 normal, Entity a) {
+    genericResponse(target, normal, a);
+    gs.particles.emit(colliderCenter(a), normal, BURST_BULLET_HIT);
+    a.vel *= 0;
+    a.obj.data.bullet.state = BulletState::colliding;
+    a.obj.sprite = res.SPR_BULLET_HIT;
+    a.obj.anim.play(res.ANIM_BULLET_HIT);
+    a.collider.x = a.collider.y = 0;
+    a.collider.w = a.collider.h = res.BULLET_HIT_SIZE; // exploding sprite has new size
+}
+
+// whether obj is stopped by solid level tiles at the moment
+bool collidesWithLevel(const GameObject &obj) {
+    switch (obj.type) {
+        case ObjectType::player: {
+            return obj.data.player.state != PlayerState::dead;
+        }
+        case ObjectType::bullet: {
+            return obj.data.bullet.state == BulletState::moving;
+        }
+        case ObjectType::enemy: {
+            return obj.data.enemy.state != EnemyState::dead; // dead enemies fall through the floor
+        }
+    }
+    return false;
+}
+
+// a ran into a solid level tile, see sweepTiles
+void levelResponse(GameState &gs, const Resources &res, const SDL_FRect &cell, glm::vec2 normal, Entity a) {
+    switch (a.obj.type) {
+        case ObjectType::player:
+        case ObjectType::enemy: {
+            genericResponse(cell, normal, a);
+            break;
+        }
+        case ObjectType::bullet: {
+            bulletImpact(gs, res, cell, normal, a);
+            break;
+        }
+    }
+}
+
+// rectB is where b is now, normal points from the face of it a ran into towards a
+void collisionResponse(const SDLState &state, GameState &gs, const Resources &res, 
+                       const SDL_FRect &rectB, glm::vec2 normal,
+                       Entity a, Entity b, float deltaTime) 
+{
     // obj we are checking
-    if (a.type == ObjectType::player) {
-        if (a.data.player.state != PlayerState::dead) {
+    if (a.obj.type == ObjectType::player) {
+        if (a.obj.data.player.state != PlayerState::dead) {
             // obj a is colliding with
-            switch (b.type) {
-                case ObjectType::level: {
-                    genericResponse();
-                    break;
-                }
+            switch (b.obj.type) {
                 case ObjectType::enemy: {
-                    if (b.data.enemy.state != EnemyState::dead) {
-                        PlayerData &d = a.data.player;
+                    if (b.obj.data.enemy.state != EnemyState::dead) {
+                        PlayerData &d = a.obj.data.player;
                         d.healthPoints -= 1;
                         if (d.healthPoints <= 0) {
                             const float JUMP_DEAD = -350.0f;
                             d.state = PlayerState::dead;
-                            a.texture = res.texDie;
-                            a.curAnimation = res.ANIM_PLAYER_DIE;
+                            gs.particles.emit(colliderCenter(a), glm::vec2(0), BURST_PLAYER_DEATH);
+                            a.obj.sprite = res.SPR_DIE;
+                            a.obj.anim.play(res.ANIM_PLAYER_DIE);
                             a.vel.x = 0;
                             a.vel.y = JUMP_DEAD;
                         }
                     }
-                    /*if (b.data.enemy.state != EnemyState::dead) {
-                        a.vel = glm::vec2(100, 0) * -a.dir;
+                    /*if (b.obj.data.enemy.state != EnemyState::dead) {
+                        a.vel = glm::vec2(100, 0) * -a.obj.dir;
                     }
                     break;*/ // this would push the player away when touching an enemy. its buggy
                 }
             }
         }
         
-    } else if (a.type == ObjectType::bullet) {
-        bool passthrough = false;
-        switch (a.data.bullet.state) {
+    } else if (a.obj.type == ObjectType::bullet) {
+        switch (a.obj.data.bullet.state) {
             case BulletState::moving:
             {
-                switch (b.type) {
-                    case ObjectType::level: {
-                        break;
-                    }
+                switch (b.obj.type) {
                     case ObjectType::enemy: {
-                        EnemyData &d = b.data.enemy;
+                        EnemyData &d = b.obj.data.enemy;
                         if (d.state != EnemyState::dead) {
-                            if (b.dir == a.dir) {
-                                b.dir = -a.dir; // turn enemy around
+                            if (b.obj.dir == a.obj.dir) {
+                                b.obj.dir = -a.obj.dir; // turn enemy around
                                 b.vel.x = -b.vel.x;
                             }
-                            b.shouldFlash = true;
-                            b.flashTimer.reset();
+                            b.obj.shouldFlash = true;
+                            b.obj.flashTimer.reset();
                             // could change enemy sprite here if needed
                             d.state = EnemyState::damaged;
                             // damage enemy and flag dead if needed
@@ -694,41 +1695,27 @@ void collisionResponse(const SDLState &state, GameState &gs, const Resources &re
                             if (d.healthPoints <= 0) {
                                 const float JUMP_DEAD = -10.0f;
                                 d.state = EnemyState::dead;
-                                b.texture = res.texSpinyDead;
-                                b.curAnimation = res.ANIM_ENEMY_DEAD;
+                                gs.particles.emit(colliderCenter(b), glm::vec2(0), BURST_ENEMY_DEATH);
+                                b.obj.sprite = res.SPR_SPINY_DEAD;
+                                b.obj.anim.play(res.ANIM_ENEMY_DEAD);
                                 b.pos.y += JUMP_DEAD; // make the enemy jump up a bit when they die then pass thru the floor
+                                b.grounded = false; // off the ground now, its sensor may have run before the hop
                             }
-                            b.vel.x += 25.0f * b.dir;
-                        } else {
-                            passthrough = true;
-                        }
+                            b.vel.x += 25.0f * b.obj.dir;
+                            bulletImpact(gs, res, rectB, normal, a);
+                        } // dead enemies let bullets pass through
                         break;
                     }
                 }
-                if (b.type != ObjectType::player && !passthrough) {
-                    genericResponse();
-                    a.vel *= 0;
-                    a.data.bullet.state = BulletState::colliding;
-                    a.texture = res.texBulletHit;
-                    a.curAnimation = res.ANIM_BULLET_HIT;
-                    a.collider.x = a.collider.y = 0;
-                    a.collider.w = a.collider.h = static_cast<float>(res.texBulletHit->h); // exploding sprite has new size
-                }
                 break;
             }
         }
-    } else if (a.type == ObjectType::enemy) {
+    } else if (a.obj.type == ObjectType::enemy) {
         // obj a is colliding with
-        switch (b.type) {
-            case ObjectType::level: {
-                if (a.data.enemy.state != EnemyState::dead) {
-                    genericResponse();
-                    break;
-                }
-            }
+        switch (b.obj.type) {
             case ObjectType::enemy: {
-                if (a.data.enemy.state != EnemyState::dead && b.data.enemy.state != EnemyState::dead) {
-                    genericResponse();
+                if (a.obj.data.enemy.state != EnemyState::dead && b.obj.data.enemy.state != EnemyState::dead) {
+                    genericResponse(rectB, normal, a);
                     break;
                 }
             }
@@ -736,27 +1723,130 @@ void collisionResponse(const SDLState &state, GameState &gs, const Resources &re
     }
 }
 
-void checkCollision(const SDLState &state, GameState &gs, const Resources &res, GameObject &a, GameObject &b, float deltaTime) {
-    SDL_FRect rectA { // create rectangle c by intersecting a and b; if c exists, its height is y coordinates overlapping and width is x coordinates overlapping
-        .x = a.pos.x + a.collider.x, 
-        .y = a.pos.y + a.collider.y,
-        .w = a.collider.w, 
-        .h = a.collider.h
-    };
-    SDL_FRect rectB {
-        .x = b.pos.x + b.collider.x, 
-        .y = b.pos.y + b.collider.y,
-        .w = b.collider.w, 
-        .h = b.collider.h
+void buildBroadphase(GameState &gs) {
+    gs.grid.clear();
+    gs.candidatePairs = gs.collisionHits = 0;
+    for (size_t i = 0; i < gs.characters.size(); i++) {
+        const glm::vec2 &pos = gs.characters.pos[i];
+        const SDL_FRect &collider = gs.characters.collider[i];
+        SDL_FRect rect {
+            .x = pos.x + collider.x,
+            .y = pos.y + collider.y,
+            .w = collider.w,
+            .h = collider.h
+        };
+        gs.grid.insert(static_cast<int>(i), rect);
+    }
+    gs.grid.build();
+}
+
+// characters of type overlapping rect, ascending. from the broadphase grid, so as of the last
+// buildBroadphase. q lets several threads query at once
+void findCharacters(const GameState &gs, const SDL_FRect &rect, ObjectType type, std::vector<int> &out, GridQuery &q) {
+    gs.grid.queryRect(rect, out, q);
+    std::erase_if(out, [&gs, type](int id) { return gs.characters.objects[id].type != type; });
+}
+
+// characters of type whose collider comes within radius of center, ascending
+void findCharacters(const GameState &gs, glm::vec2 center, float radius, ObjectType type, std::vector<int> &out, GridQuery &q) {
+    gs.grid.queryRadius(center.x, center.y, radius, out, q);
+    std::erase_if(out, [&gs, type](int id) { return gs.characters.objects[id].type != type; });
+}
+
+// level of detail for enemy logic: enemies around the camera and near the player update every
+// tick, ones within a screen of it every AI_MID_PERIOD ticks and the rest every AI_FAR_PERIOD.
+// movement and collision still run every tick for everyone, only update() is thinned out.
+// also tells the enemies close to the player they noticed it
+void scheduleAI(GameState &gs) {
+    const size_t n = gs.characters.size();
+    gs.aiPeriod.assign(n, gs.aiLod ? AI_FAR_PERIOD : 1);
+    for (GameObject &obj : gs.characters.objects) {
+        if (obj.type == ObjectType::enemy) {
+            obj.data.enemy.aware = false;
+        }
+    }
+    if (gs.aiLod) {
+        const SDL_FRect &view = gs.mapViewport;
+        const SDL_FRect around { .x = view.x - view.w, .y = view.y - view.h, .w = view.w * 3, .h = view.h * 3 };
+        findCharacters(gs, around, ObjectType::enemy, gs.found, gs.foundQuery);
+        for (int i : gs.found) {
+            gs.aiPeriod[i] = AI_MID_PERIOD;
+        }
+        const SDL_FRect visible {
+            .x = view.x - CULL_MARGIN,
+            .y = view.y - CULL_MARGIN,
+            .w = view.w + 2 * CULL_MARGIN,
+            .h = view.h + 2 * CULL_MARGIN
+        };
+        findCharacters(gs, visible, ObjectType::enemy, gs.found, gs.foundQuery);
+        for (int i : gs.found) {
+            gs.aiPeriod[i] = 1;
+        }
+    }
+    for (int slot = 0; slot < gs.playerCount; slot++) { // an enemy close to both goes after the last one
+        Entity player = gs.player(slot);
+        if (player.obj.data.player.state == PlayerState::dead) {
+            continue;
+        }
+        findCharacters(gs, colliderCenter(player), AI_AWARE_RADIUS, ObjectType::enemy, gs.found, gs.foundQuery);
+        for (int i : gs.found) {
+            EnemyData &d = gs.characters.objects[i].data.enemy;
+            d.aware = true;
+            d.target = slot;
+            gs.aiPeriod[i] = 1;
+        }
+    }
+    gs.aiUpdates = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (gs.characters.objects[i].type == ObjectType::enemy && (gs.tick + i) % gs.aiPeriod[i] == 0) {
+            gs.aiUpdates++;
+        }
+    }
+}
+
+// picks the characters and bullets near the camera for drawing. characters come from the
+// broadphase grid of the last tick, the margin covers movement since and interpolation
+void cullSprites(GameState &gs) {
+    const SDL_FRect view {
+        .x = gs.drawViewport.x - CULL_MARGIN,
+        .y = gs.drawViewport.y - CULL_MARGIN,
+        .w = gs.drawViewport.w + 2 * CULL_MARGIN,
+        .h = gs.drawViewport.h + 2 * CULL_MARGIN
     };
-    SDL_FRect rectC{ 0 };
-    if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC)) {
-        // found intersection, respond accordingly
-        collisionResponse(state, gs, res, rectA, rectB, rectC, a, b, deltaTime);
+    gs.grid.query(view, gs.visibleCharacters); // ascending, same draw order as a full loop
+    // bullets are few and already retired once they leave the screen, a plain test is enough
+    gs.visibleBullets.clear();
+    for (size_t i = 0; i < gs.bullets.size(); i++) {
+        const glm::vec2 &pos = gs.bullets.pos[i];
+        const SDL_FRect &collider = gs.bullets.collider[i];
+        const SDL_FRect rect { .x = pos.x, .y = pos.y, .w = collider.w, .h = collider.h };
+        if (SDL_HasRectIntersectionFloat(&rect, &view)) {
+            gs.visibleBullets.push_back(static_cast<int>(i));
+        }
+    }
+}
+
+// did a run into b during the tick. a is swept relative to b from where both started, so fast
+// objects can't pass through each other between two ticks
+bool checkCollision(const SDLState &state, GameState &gs, const Resources &res, Entity a, Entity b, float deltaTime) {
+    const SDL_FRect rectB = colliderRect(b.pos, b.collider);
+    SweepHit hit;
+    if (!sweepRect(colliderRect(a.prevPos, a.collider), (a.pos - a.prevPos) - (b.pos - b.prevPos),
+                   colliderRect(b.prevPos, b.collider), hit)) {
+        // not moving into each other, but they may have been overlapping since before the tick
+        const SDL_FRect rectA = colliderRect(a.pos, a.collider);
+        if (!rectsOverlap(rectA, rectB)) {
+            return false;
+        }
+        hit.normal = pushOutNormal(rectA, rectB);
     }
+    // found intersection, respond accordingly
+    collisionResponse(state, gs, res, rectB, hit.normal, a, b, deltaTime);
+    return true;
 }
 
-void createTiles(const SDLState &state, GameState &gs, const Resources &res) { // 50 x 5
+// the original 50 x 5 level, kept in the source so the game runs without level files
+LevelBuffer builtinLevel() {
     /*
         1 - Stone
         2 - Brick
@@ -787,120 +1877,906 @@ void createTiles(const SDLState &state, GameState &gs, const Resources &res) { /
         0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,7,7,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
         0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
     };
-    const auto loadMap = [&state, &gs, &res](short layer[MAP_ROWS][MAP_COLS])
-    {
-        const auto createObject = [&state](int r, int c, SDL_Texture *tex, ObjectType type) {
-            GameObject o;
-            o.type = type; 
-            o.pos = glm::vec2(c * TILE_SIZE, state.logH - (MAP_ROWS - r) * TILE_SIZE); // subtract r from map rows to not be backwards. drawn top to bottom and flush with resolution
-            o.texture = tex;
-            o.collider = {
-                .x = 0,
-                .y = 0,
-                .w = TILE_SIZE,
-                .h = TILE_SIZE
-            };
-            return o;
-        };
-        for (int r = 0; r < MAP_ROWS; r++) {
-            for (int c = 0; c < MAP_COLS; c++) {
-                switch (layer[r][c]) {
-                    case 1: // stone
-                    {
-                        GameObject o = createObject(r, c, res.texStone, ObjectType::level);
-                        gs.layers[LAYER_IDX_LEVEL].push_back(o);
-                        break;
-                    }
-                    case 2: // brick
-                    {
-                        GameObject o = createObject(r, c, res.texBrick, ObjectType::level);
-                        gs.layers[LAYER_IDX_LEVEL].push_back(o);
-                        break;
-                    }
-                    case 3: // enemy
-                    {
-                        GameObject o = createObject(r, c, res.texSpiny, ObjectType::enemy);
-                        o.data.enemy = EnemyData();
-                        o.curAnimation = res.ANIM_ENEMY;
-                        o.animations = res.enemyAnims;
-                        o.collider = SDL_FRect {
-                            .x = 2,
-                            .y = 2,
-                            .w = 28,
-                            .h = 30
-                        };
-                        o.dynamic = true;
-                        o.maxSpeedX = 100;
-                        o.vel.x = 50.0f;
-                        o.acc = glm::vec2(300, 0);
-                        gs.layers[LAYER_IDX_CHARACTERS].push_back(o);
-                        break;
-                    }
-                    case 4: // player
-                    {
-                        GameObject player = createObject(r, c, res.texIdle, ObjectType::player);
-                        player.data.player = PlayerData(); // initialize player data to idle
-                        player.animations = res.playerAnims; // load anims
-                        player.curAnimation = res.ANIM_PLAYER_IDLE; // set player anim to idle
-                        player.acc = glm::vec2(300, 0);
-                        player.maxSpeedX = 150;
-                        player.dynamic = true;
-                        player.collider = { 
-                            .x = 1,
-                            .y = 1,
-                            .w = 28,
-                            .h = 30 // more accurate at 31, bug caused where player stuck in jump state in small ceilings
-                        };
-                        gs.layers[LAYER_IDX_CHARACTERS].push_back(player); // put into array
-                        gs.playerIndex = gs.layers[LAYER_IDX_CHARACTERS].size() - 1;
-                        break;
-                    }
-                    case 5: // grass
-                    {
-                        GameObject o = createObject(r, c, res.texGrass, ObjectType::level);
-                        gs.layers[LAYER_IDX_LEVEL].push_back(o);
-                        break;
-                    }
-                    case 6: // bush
-                    {
-                        GameObject o = createObject(r, c, res.texBush, ObjectType::level);
-                        gs.fgTiles.push_back(o);
-                        break;
-                    }
-                    case 7: // fence
-                    {
-                        GameObject o = createObject(r, c, res.texFence, ObjectType::level);
-                        gs.bgTiles.push_back(o);
-                        break;
-                    }
+    LevelBuffer level(MAP_ROWS, MAP_COLS);
+    convertTileCodes(&map[0][0], level);
+    convertTileCodes(&background[0][0], level);
+    convertTileCodes(&foreground[0][0], level);
+    return level;
+}
+
+// adds a row major array of the tile codes above to level, same size as the level
+void convertTileCodes(const short *codes, LevelBuffer &level) {
+    for (int r = 0; r < level.rows; r++) {
+        for (int c = 0; c < level.cols; c++) {
+            const size_t cell = static_cast<size_t>(c) * level.rows + r;
+            switch (codes[r * level.cols + c]) {
+                case 1: // stone
+                {
+                    level.layers[LEVEL_LAYER_SOLID][cell] = TILE_STONE;
+                    break;
                 }
+                case 2: // brick
+                {
+                    level.layers[LEVEL_LAYER_SOLID][cell] = TILE_BRICK;
+                    break;
+                }
+                case 3: // enemy
+                {
+                    level.spawns.push_back(LevelSpawn { .kind = SpawnKind::enemy, .row = static_cast<uint32_t>(r), .col = static_cast<uint32_t>(c) });
+                    break;
+                }
+                case 4: // player
+                {
+                    level.spawns.push_back(LevelSpawn { .kind = SpawnKind::player, .row = static_cast<uint32_t>(r), .col = static_cast<uint32_t>(c) });
+                    break;
+                }
+                case 5: // grass
+                {
+                    level.layers[LEVEL_LAYER_SOLID][cell] = TILE_GRASS;
+                    break;
+                }
+                case 6: // bush
+                {
+                    level.layers[LEVEL_LAYER_FRONT][cell] = TILE_BUSH;
+                    break;
+                }
+                case 7: // fence
+                {
+                    level.layers[LEVEL_LAYER_BACK][cell] = TILE_FENCE;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool exportLevel(const char *path) {
+    const LevelBuffer level = builtinLevel();
+    const uint8_t *layers[LEVEL_LAYER_COUNT];
+    for (int i = 0; i < LEVEL_LAYER_COUNT; i++) {
+        layers[i] = level.layers[i].data();
+    }
+    if (!writeLevel(path, level.rows, level.cols, layers, level.spawns)) {
+        SDL_Log("Couldn't write level %s", path);
+        return false;
+    }
+    return true;
+}
+
+void createTiles(const SDLState &state, GameState &gs, const Resources &res) {
+    loadLevel(state, gs, res, builtinLevel());
+}
+
+// copies level into the tile maps
+void loadLevel(const SDLState &state, GameState &gs, const Resources &res, const LevelBuffer &level) {
+    gs.levelFile.close();
+    clearLevel(state, gs, level.rows, level.cols);
+    for (int c = 0; c < level.cols; c++) {
+        for (int r = 0; r < level.rows; r++) {
+            const size_t cell = static_cast<size_t>(c) * level.rows + r;
+            gs.tiles.set(r, c, level.layers[LEVEL_LAYER_SOLID][cell]);
+            gs.bgTiles.set(r, c, level.layers[LEVEL_LAYER_BACK][cell]);
+            gs.fgTiles.set(r, c, level.layers[LEVEL_LAYER_FRONT][cell]);
+        }
+    }
+    spawnAll(state, gs, res, level.spawns.data(), static_cast<int>(level.spawns.size()));
+    finishLevel(state, gs, res);
+}
+
+// maps a level file, the tile maps use its layers in place so only the pages the game touches
+// (the columns near the camera) are ever read from disk. false leaves the level empty
+bool loadLevelFile(const SDLState &state, GameState &gs, const Resources &res, const char *path) {
+    std::string error;
+    if (!gs.levelFile.open(path, error)) {
+        SDL_Log("Couldn't load level %s: %s", path, error.c_str());
+        return false;
+    }
+    const LevelFile &level = gs.levelFile;
+    const float top = state.logH - level.rows() * TILE_SIZE;
+    gs.tiles.view(level.rows(), level.cols(), TILE_SIZE, 0, top, level.layer(LEVEL_LAYER_SOLID));
+    gs.bgTiles.view(level.rows(), level.cols(), TILE_SIZE, 0, top, level.layer(LEVEL_LAYER_BACK));
+    gs.fgTiles.view(level.rows(), level.cols(), TILE_SIZE, 0, top, level.layer(LEVEL_LAYER_FRONT));
+    clearEntities(gs);
+    if (!spawnAll(state, gs, res, level.spawns(), level.spawnCount())) {
+        SDL_Log("Couldn't load level %s: no player spawn", path);
+        clearEntities(gs);
+        gs.levelFile.close();
+        return false;
+    }
+    finishLevel(state, gs, res);
+    return true;
+}
+
+// empty tile maps sitting on the bottom of the screen, no characters or bullets
+void clearLevel(const SDLState &state, GameState &gs, int rows, int cols) {
+    const float top = state.logH - rows * TILE_SIZE; // drawn top to bottom and flush with resolution
+    gs.tiles.resize(rows, cols, TILE_SIZE, 0, top);
+    gs.bgTiles.resize(rows, cols, TILE_SIZE, 0, top);
+    gs.fgTiles.resize(rows, cols, TILE_SIZE, 0, top);
+    clearEntities(gs);
+}
+
+void clearEntities(GameState &gs) {
+    gs.characters.clear();
+    gs.bullets.clear();
+    gs.particles.clear();
+    std::fill(gs.playerIndices, gs.playerIndices + MAX_PLAYERS, -1);
+}
+
+// spawns characters at their cells, ones outside the map are skipped. false without a player
+bool spawnAll(const SDLState &state, GameState &gs, const Resources &res, const LevelSpawn *spawns, int count) {
+    for (int i = 0; i < count; i++) {
+        const int r = static_cast<int>(spawns[i].row);
+        const int c = static_cast<int>(spawns[i].col);
+        if (r >= gs.tiles.getRows() || c >= gs.tiles.getCols()) {
+            continue;
+        }
+        switch (spawns[i].kind) {
+            case SpawnKind::player:
+            {
+                spawnPlayer(state, gs, res, r, c);
+                break;
+            }
+            case SpawnKind::enemy:
+            {
+                spawnEnemy(state, gs, res, r, c);
+                break;
+            }
+        }
+    }
+    return gs.playerIndices[0] != -1;
+}
+
+glm::vec2 cellPos(const GameState &gs, int r, int c) {
+    const SDL_FRect cell = gs.tiles.cellRect(r, c);
+    return glm::vec2(cell.x, cell.y);
+}
+
+void spawnEnemy(const SDLState &state, GameState &gs, const Resources &res, int r, int c) {
+    spawnEnemyAt(gs, res, cellPos(gs, r, c));
+}
+
+size_t spawnEnemyAt(GameState &gs, const Resources &res, glm::vec2 pos) {
+    GameObject o;
+    Body body;
+    o.type = ObjectType::enemy;
+    o.data.enemy = EnemyData();
+    o.sprite = res.SPR_SPINY;
+    o.anim.play(res.ANIM_ENEMY);
+    body.pos = pos;
+    body.collider = SDL_FRect {
+        .x = 2,
+        .y = 2,
+        .w = 28,
+        .h = 30
+    };
+    body.dynamic = true;
+    body.maxSpeedX = 100;
+    body.vel.x = 50.0f;
+    body.acc = glm::vec2(300, 0);
+    return gs.characters.add(body, o);
+}
+
+void spawnPlayer(const SDLState &state, GameState &gs, const Resources &res, int r, int c) {
+    spawnPlayerAt(gs, res, cellPos(gs, r, c));
+}
+
+// as the first player without a character, spawns beyond gs.playerCount are ignored
+void spawnPlayerAt(GameState &gs, const Resources &res, glm::vec2 pos) {
+    const int slot = static_cast<int>(std::find(gs.playerIndices, gs.playerIndices + gs.playerCount, -1) - gs.playerIndices);
+    if (slot == gs.playerCount) {
+        return;
+    }
+    GameObject player;
+    Body body;
+    player.type = ObjectType::player;
+    player.data.player = PlayerData(); // initialize player data to idle
+    player.data.player.slot = slot;
+    player.sprite = res.SPR_IDLE;
+    player.anim.play(res.ANIM_PLAYER_IDLE); // set player anim to idle
+    body.pos = pos;
+    body.acc = glm::vec2(300, 0);
+    body.maxSpeedX = 150;
+    body.dynamic = true;
+    body.collider = { 
+        .x = 1,
+        .y = 1,
+        .w = 28,
+        .h = 30 // more accurate at 31, bug caused where player stuck in jump state in small ceilings
+    };
+    gs.playerIndices[slot] = static_cast<int>(gs.characters.add(body, player)); // put into array
+}
+
+// called once tiles and objects are in place
+void finishLevel(const SDLState &state, GameState &gs, const Resources &res) {
+    assert(gs.playerIndices[0] != -1);
+    for (int slot = 1; slot < gs.playerCount; slot++) { // levels have one player spawn, the others start there too
+        spawnPlayerAt(gs, res, gs.player().pos);
+    }
+    gs.mapViewport.x = gs.prevViewportX = cameraX(gs);
+    const int cols = gs.tiles.getCols();
+    gs.stream.setup(cols, gs.streaming ? STREAM_CHUNK_COLS : cols, TILE_SIZE);
+    streamWorld(state, gs, res); // parks everything away from the camera
+    buildBroadphase(gs); // drawing culls with the grid, so it has to be valid before the first tick
+    setupTileChunks(state, gs, res);
+    gs.initial.characters = gs.characters;
+    gs.initial.stream = gs.stream;
+    std::copy(gs.playerIndices, gs.playerIndices + MAX_PLAYERS, gs.initial.playerIndices);
+    gs.initial.viewportX = gs.mapViewport.x;
+    gs.rewind.clear(); // snapshots of another level
+}
+
+// puts the level back the way finishLevel left it, without parsing, loading or spawning
+// anything: characters and parked enemies are copied over from the snapshot, bullets and effects
+// are dropped. the copies go into storage the live stores already have, so once the stores have
+// grown to the level's size a restart is a handful of memcpys and no allocations
+void restartLevel(const SDLState &state, GameState &gs) {
+    gs.characters = gs.initial.characters;
+    gs.stream = gs.initial.stream;
+    std::copy(gs.initial.playerIndices, gs.initial.playerIndices + MAX_PLAYERS, gs.playerIndices);
+    gs.bullets.clear();
+    gs.bulletRecycle = 0;
+    gs.particles.clear();
+    gs.mapViewport.x = gs.prevViewportX = gs.drawViewport.x = gs.initial.viewportX;
+    gs.bg2Scroll = gs.bg3Scroll = gs.bg4Scroll = 0;
+    fitGrid(state, gs);
+    buildBroadphase(gs);
+    gs.restartPending = false;
+}
+
+// activates the chunks around the camera and suspends the ones that fell out of range. characters
+// outside the active chunks are parked, also ones that walked out, and dead enemies are dropped
+// since all they do is fall off screen
+// true if characters were parked or came back, which invalidates the broadphase grid
+bool streamWorld(const SDLState &state, GameState &gs, const Resources &res) {
+    const bool moved = gs.stream.retarget(gs.mapViewport, gs.enteredChunks, gs.leftChunks);
+    bool changed = false;
+    for (size_t i = gs.characters.size(); i-- > 0;) {
+        Entity e = gs.characters[i];
+        if (e.obj.type == ObjectType::player || gs.stream.isActive(e.pos.x)) {
+            continue;
+        }
+        if (e.obj.type == ObjectType::enemy && e.obj.data.enemy.state != EnemyState::dead) {
+            gs.stream.park(ParkedEnemy {
+                .pos = e.pos,
+                .vel = e.vel,
+                .dir = static_cast<int8_t>(e.obj.dir),
+                .state = static_cast<uint8_t>(e.obj.data.enemy.state),
+                .healthPoints = static_cast<int16_t>(e.obj.data.enemy.healthPoints)
+            });
+        }
+        const size_t last = gs.characters.size() - 1;
+        gs.characters.remove(i); // swaps the last character in
+        changed = true;
+        std::replace(gs.playerIndices, gs.playerIndices + MAX_PLAYERS, static_cast<int>(last), static_cast<int>(i));
+    }
+    if (!moved) {
+        return changed;
+    }
+    for (int k : gs.enteredChunks) {
+        gs.stream.unpark(k, gs.unparked);
+        for (const ParkedEnemy &p : gs.unparked) {
+            Entity e = gs.characters[spawnEnemyAt(gs, res, p.pos)];
+            e.vel = p.vel;
+            e.obj.dir = p.dir;
+            e.obj.data.enemy.state = static_cast<EnemyState>(p.state);
+            e.obj.data.enemy.healthPoints = p.healthPoints;
+        }
+    }
+    if (gs.levelFile.isOpen()) { // tiles of suspended chunks can leave memory too
+        const int chunkCols = gs.stream.getChunkCols();
+        for (int k : gs.leftChunks) {
+            gs.levelFile.discardColumns(k * chunkCols, std::min((k + 1) * chunkCols, gs.tiles.getCols()));
+        }
+    }
+    fitGrid(state, gs);
+    return true; // the grid was resized
+}
+
+// broadphase cells line up with the tile lattice over the active chunks, rows cover the whole screen height
+void fitGrid(const SDLState &state, GameState &gs) {
+    const int activeCols = (gs.stream.getLast() - gs.stream.getFirst() + 1) * gs.stream.getChunkCols();
+    gs.grid.resize(activeCols, (state.logH + TILE_SIZE - 1) / TILE_SIZE, TILE_SIZE, gs.stream.activeLeft());
+}
+
+// struct sizes a snapshot depends on, see WorldSnapshot
+uint32_t snapshotLayout() {
+    return WorldSnapshot::layoutOf({ sizeof(WorldSnapshot::Header), sizeof(GameObject), sizeof(ParkedEnemy),
+                                     sizeof(glm::vec2), sizeof(SDL_FRect) });
+}
+
+// everything a tick reads that earlier ticks wrote, so restoring it and simulating the same
+// input gives the same world bit for bit. tiles, textures and clips are left out, objects only
+// refer to them by id. what is derived every tick (broadphase, AI schedule) is rebuilt instead.
+// snap's buffer is reused, capturing into the same snapshot again doesn't allocate
+void captureSnapshot(const GameState &gs, WorldSnapshot &snap) {
+    snap.bytes.clear();
+    SnapshotWriter out(snap.bytes);
+    out.put(WorldSnapshot::Header {
+        .magic = { 'S', 'N', 'A', 'P' },
+        .version = WorldSnapshot::VERSION,
+        .layout = snapshotLayout(),
+        .cols = gs.tiles.getCols(),
+        .rows = gs.tiles.getRows(),
+        .tick = gs.tick
+    });
+    out.put(gs.rng);
+    out.put(gs.playerCount);
+    out.put(gs.playerIndices);
+    out.put(gs.mapViewport.x);
+    out.put(gs.prevViewportX);
+    out.put(static_cast<uint64_t>(gs.bulletRecycle));
+    out.put(gs.bulletsDropped);
+    gs.characters.save(out);
+    gs.bullets.save(out);
+    gs.stream.save(out);
+}
+
+// puts the world back the way captureSnapshot found it. false if snap is from another build or
+// level or damaged, a damaged one can leave the world half restored
+bool restoreSnapshot(const SDLState &state, GameState &gs, const WorldSnapshot &snap) {
+    SnapshotReader in(snap.bytes);
+    WorldSnapshot::Header header;
+    if (!in.get(header) || memcmp(header.magic, "SNAP", 4) != 0 || header.version != WorldSnapshot::VERSION ||
+        header.layout != snapshotLayout() || header.cols != gs.tiles.getCols() || header.rows != gs.tiles.getRows()) {
+        return false;
+    }
+    uint64_t bulletRecycle = 0;
+    int playerCount = 0;
+    gs.tick = header.tick;
+    in.get(gs.rng);
+    if (!in.get(playerCount) || playerCount != gs.playerCount) {
+        return false;
+    }
+    in.get(gs.playerIndices);
+    in.get(gs.mapViewport.x);
+    in.get(gs.prevViewportX);
+    in.get(bulletRecycle);
+    in.get(gs.bulletsDropped);
+    gs.bulletRecycle = static_cast<size_t>(bulletRecycle);
+    if (!gs.characters.load(in) || !gs.bullets.load(in) || !gs.stream.load(in) || !in.atEnd()) {
+        return false;
+    }
+    for (int slot = 0; slot < gs.playerCount; slot++) {
+        if (gs.playerIndices[slot] < 0 || gs.playerIndices[slot] >= static_cast<int>(gs.characters.size())) {
+            return false;
+        }
+    }
+    gs.drawViewport.x = gs.mapViewport.x;
+    gs.restartPending = false;
+    fitGrid(state, gs);
+    buildBroadphase(gs); // drawing culls with it
+    return true;
+}
+
+// every REWIND_STRIDE ticks the world goes into the rewind ring
+void keepRewindSnapshot(GameState &gs) {
+    if (gs.tick % REWIND_STRIDE != 0) {
+        return;
+    }
+    const uint64_t start = SDL_GetPerformanceCounter();
+    captureSnapshot(gs, gs.rewind.push());
+    gs.snapshotMS = gs.profiler.toMS(SDL_GetPerformanceCounter() - start);
+}
+
+// instead of a tick while rewinding: back to the newest snapshot, which is then dropped unless
+// it's the last one, so rewinding stops at the oldest
+void rewindTick(const SDLState &state, GameState &gs) {
+    if (gs.rewind.size() == 0) {
+        return;
+    }
+    if (!restoreSnapshot(state, gs, gs.rewind.getNewest())) {
+        gs.rewind.clear();
+        return;
+    }
+    if (gs.rewind.size() > 1) {
+        gs.rewind.pop();
+    }
+}
+
+// one tick of a rollback session. takes in the inputs the other side sent and, if a prediction
+// was wrong, goes back to the tick it was used first and simulates from there again. then, if
+// advance, simulates the next tick with localInput, unless that would get more than
+// MAX_ROLLBACK ticks ahead of the other side's inputs. sends our inputs either way.
+// false if the tick had to wait
+bool netTick(const SDLState &state, NetPeer &peer, Resources &res, float deltaTime, uint8_t localInput, bool advance) {
+    if (peer.desynced) {
+        return false;
+    }
+    const int remote = peer.localSlot ^ 1;
+    int rollbackFrom = INT_MAX;
+    InputPacket in;
+    while (peer.transport.receive(peer.packet)) {
+        if (!in.read(peer.packet)) {
+            continue;
+        }
+        peer.remoteAck = std::max(peer.remoteAck, in.ack);
+        for (int k = 0; k < in.count; k++) {
+            const int wrong = peer.inputs.confirm(remote, in.first + k, in.inputs[k]);
+            if (wrong >= 0) {
+                rollbackFrom = std::min(rollbackFrom, wrong);
             }
         }
+    }
+    if (rollbackFrom < peer.tick) {
+        const uint64_t start = SDL_GetPerformanceCounter();
+        if (!restoreSnapshot(state, peer.gs, peer.saved[rollbackFrom % peer.saved.size()])) {
+            SDL_Log("Peer %d couldn't roll back to tick %d, ending the rollback session", peer.localSlot, rollbackFrom);
+            peer.desynced = true; // simulating on from the world as it is would drift apart without anyone noticing
+            return false;
+        }
+        peer.gs.particles.setMuted(true); // the effects were seen the first time
+        for (int t = rollbackFrom; t < peer.tick; t++) {
+            simulateNetTick(state, peer, res, deltaTime, t);
+        }
+        peer.gs.particles.setMuted(false);
+        peer.lastResimMS = peer.gs.profiler.toMS(SDL_GetPerformanceCounter() - start);
+        peer.resimTimes.push_back(peer.lastResimMS);
+        peer.lastDepth = peer.tick - rollbackFrom;
+        peer.maxDepth = std::max(peer.maxDepth, peer.lastDepth);
+        peer.rollbacks++;
+    }
+    bool advanced = false;
+    if (advance && peer.tick - peer.inputs.getConfirmed(remote) < MAX_ROLLBACK) {
+        peer.inputs.confirm(peer.localSlot, peer.tick, localInput);
+        simulateNetTick(state, peer, res, deltaTime, peer.tick);
+        peer.tick++;
+        advanced = true;
+    } else if (advance) {
+        peer.stalls++; // the saved worlds don't reach back further
+    }
+    InputPacket out {
+        .first = peer.remoteAck,
+        .ack = peer.inputs.getConfirmed(remote),
+        .count = std::min(peer.inputs.getConfirmed(peer.localSlot) - peer.remoteAck, static_cast<int>(InputPacket::MAX_INPUTS))
     };
-    loadMap(map);
-    loadMap(background);
-    loadMap(foreground);
-    assert(gs.playerIndex != -1);
+    for (int k = 0; k < out.count; k++) {
+        out.inputs[k] = peer.inputs.getKnown(peer.localSlot, out.first + k);
+    }
+    out.write(peer.packet);
+    peer.transport.send(peer.packet);
+    return advanced;
+}
+
+// keeps the world at the start of tick for rolling back to, then simulates it with the inputs
+// known or predicted for it
+void simulateNetTick(const SDLState &state, NetPeer &peer, Resources &res, float deltaTime, int tick) {
+    captureSnapshot(peer.gs, peer.saved[tick % peer.saved.size()]);
+    uint8_t inputs[MAX_PLAYERS];
+    for (int slot = 0; slot < MAX_PLAYERS; slot++) {
+        inputs[slot] = peer.inputs.take(slot, tick);
+    }
+    stepSimulation(state, peer.gs, res, deltaTime, inputs);
 }
 
-void handleKeyInput(const SDLState &state, GameState &gs, GameObject &obj,
+// point the chunk caches at the static tile layers, again on every level change.
+// chunks are rendered lazily while drawing, see TileChunks
+void setupTileChunks(const SDLState &state, GameState &gs, const Resources &res) {
+    if (!state.renderer) { // headless
+        return;
+    }
+    gs.backChunks.setup(state.renderer, { &gs.bgTiles, &gs.tiles }, res.tileSprites.data(), CHUNK_COLS);
+    gs.frontChunks.setup(state.renderer, { &gs.fgTiles }, res.tileSprites.data(), CHUNK_COLS);
+}
+
+// wide floor with scattered walls and platforms, enemies dropped on random empty cells
+void createStressLevel(const SDLState &state, GameState &gs, const Resources &res, const StressConfig &cfg) {
+    clearLevel(state, gs, MAP_ROWS, cfg.cols);
+    for (int c = 0; c < cfg.cols; c++) {
+        gs.tiles.set(MAP_ROWS - 1, c, c % 7 ? TILE_STONE : TILE_BRICK); // no gaps, nothing falls out
+    }
+    for (int c = 8; c < cfg.cols - 3; c += 6 + SDL_rand(10)) {
+        if (SDL_rand(2)) {
+            gs.tiles.set(MAP_ROWS - 2, c, TILE_BRICK); // wall to bounce off
+        } else {
+            for (int k = 0; k < 3; k++) {
+                gs.tiles.set(2, c + k, TILE_GRASS); // platform
+            }
+        }
+    }
+    spawnPlayer(state, gs, res, 0, 1);
+    for (int i = 0; i < cfg.enemies; i++) {
+        const int r = SDL_rand(MAP_ROWS - 1);
+        const int c = 4 + SDL_rand(cfg.cols - 4);
+        if (!gs.tiles.get(r, c)) {
+            spawnEnemy(state, gs, res, r, c);
+        }
+    }
+    finishLevel(state, gs, res);
+}
+
+// runs the simulation without a window on a generated level and prints throughput. with
+// verifyThreads it runs a second time on one thread and reports the first tick that differs
+int runStress(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow) {
+    if (!cfg.verifyThreads) {
+        simulateStress(state, tickRate, cfg, bulletCap, bulletOverflow, cfg.threads, nullptr, true);
+        return 0;
+    }
+    std::vector<uint64_t> threaded, single;
+    simulateStress(state, tickRate, cfg, bulletCap, bulletOverflow, cfg.threads, &threaded, true);
+    simulateStress(state, tickRate, cfg, bulletCap, bulletOverflow, 1, &single, false);
+    for (int tick = 0; tick < cfg.ticks; tick++) {
+        if (threaded[tick] != single[tick]) {
+            printf("threaded run differs from the single thread run at tick %d\n", tick);
+            return 1;
+        }
+    }
+    printf("threaded run matches the single thread run on all %d ticks, checksum %016llx\n", cfg.ticks,
+           static_cast<unsigned long long>(single.back()));
+    return 0;
+}
+
+// one stress run on a job pool of threads. checksums, if given, gets worldChecksum after every tick
+void simulateStress(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow,
+                    int threads, std::vector<uint64_t> *checksums, bool report) {
+    Resources res;
+    res.load(state, false);
+    GameState gs(state);
+    setupStressWorld(state, gs, res, cfg, bulletCap, bulletOverflow, threads);
+    const auto armPlayer = [&gs, &cfg]() {
+        for (int slot = 0; slot < gs.playerCount; slot++) {
+            gs.player(slot).obj.data.player.healthPoints = INT_MAX; // keep firing for the whole run
+            if (cfg.fireInterval > 0) { // bullet hell
+                gs.player(slot).obj.data.player.weaponTimer = Timer(cfg.fireInterval);
+            }
+        }
+    };
+    armPlayer();
+
+    const float deltaTime = 1.0f / tickRate;
+    std::vector<uint64_t> tickTimes(cfg.ticks);
+    uint64_t totalPairs = 0, totalHits = 0;
+    size_t peakParticles = 0;
+    uint64_t totalAIUpdates = 0;
+    uint64_t deadTicks = 0, deadFalling = 0; // dead enemies leave through the floor, every tick after the kill should move them down
+    std::vector<double> restartTimes;
+    gs.profiler.reset(cfg.profileFrames); // the first frame starts here, not before the level was built
+    const uint64_t start = SDL_GetTicksNS();
+    for (int tick = 0; tick < cfg.ticks; tick++) {
+        const uint8_t input = stressInput(tick, tickRate);
+        if (cfg.restartEvery > 0 && tick > 0 && tick % cfg.restartEvery == 0) {
+            gs.restartPending = true; // as if the player had just finished dying
+        }
+        const uint64_t tickStart = SDL_GetTicksNS();
+        stepSimulation(state, gs, res, deltaTime, input);
+        if (gs.restarts > static_cast<int>(restartTimes.size())) {
+            restartTimes.push_back(gs.restartMS);
+            armPlayer(); // the snapshot has the player as the level made it
+        }
+        const uint64_t particleStart = SDL_GetPerformanceCounter();
+        gs.particles.update(deltaTime, GRAVITY);
+        gs.profiler.lap(PHASE_PARTICLES, particleStart);
+        peakParticles = std::max(peakParticles, gs.particles.size());
+        tickTimes[tick] = SDL_GetTicksNS() - tickStart;
+        gs.profiler.endFrame(); // a frame is a tick here
+        totalPairs += gs.candidatePairs;
+        totalHits += gs.collisionHits;
+        totalAIUpdates += gs.aiUpdates;
+        for (size_t i = 0; i < gs.characters.size(); i++) {
+            const Entity e = gs.characters[i];
+            if (e.obj.type == ObjectType::enemy && e.obj.data.enemy.state == EnemyState::dead && e.pos.y >= e.prevPos.y) { // up is the kill hop
+                deadTicks++;
+                deadFalling += e.pos.y > e.prevPos.y;
+            }
+        }
+        if (checksums) {
+            checksums->push_back(worldChecksum(gs));
+        }
+    }
+    if (!report) {
+        return;
+    }
+    const double seconds = (SDL_GetTicksNS() - start) / static_cast<double>(SDL_NS_PER_SECOND);
+
+    std::sort(tickTimes.begin(), tickTimes.end());
+    const auto percentileMS = [&tickTimes](double p) {
+        return tickTimes[static_cast<size_t>(p * (tickTimes.size() - 1))] / 1e6;
+    };
+    int enemiesAlive = 0;
+    for (const GameObject &obj : gs.characters.objects) {
+        if (obj.type == ObjectType::enemy && obj.data.enemy.state != EnemyState::dead) {
+            enemiesAlive++;
+        }
+    }
+    printf("map %d x %d, seed %llu, %d ticks at %d Hz on %d threads\n", gs.tiles.getCols(), gs.tiles.getRows(),
+           static_cast<unsigned long long>(cfg.seed), cfg.ticks, tickRate, gs.jobs.getThreadCount());
+    printf("%.3f s, %.1f ticks/s\n", seconds, cfg.ticks / seconds);
+    printf("tick p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentileMS(0.5), percentileMS(0.99), percentileMS(1.0));
+    enemiesAlive += static_cast<int>(gs.stream.getParkedCount()); // parked enemies are never dead
+    printf("characters %zu active, %zu parked (enemies alive %d), bullets %zu live / %zu cap, %d shots dropped\n",
+           gs.characters.size(), gs.stream.getParkedCount(), enemiesAlive, gs.bullets.size(), gs.bulletCap, gs.bulletsDropped);
+    printf("candidate pairs %.1f / tick, hits %.1f / tick\n",
+           totalPairs / static_cast<double>(cfg.ticks), totalHits / static_cast<double>(cfg.ticks));
+    printf("enemy logic updates %.1f / tick\n", totalAIUpdates / static_cast<double>(cfg.ticks));
+    printf("dead enemies fell on %llu of %llu ticks%s\n", static_cast<unsigned long long>(deadFalling),
+           static_cast<unsigned long long>(deadTicks), deadFalling < deadTicks ? ", some are stuck in the air" : "");
+    printf("particles %zu live, %zu peak / %zu cap, %d dropped\n", gs.particles.size(), peakParticles,
+           gs.particles.getCapacity(), gs.particles.getDropped());
+    if (!restartTimes.empty()) {
+        std::sort(restartTimes.begin(), restartTimes.end());
+        printf("restarts %zu, p50 %.3f ms, max %.3f ms\n", restartTimes.size(),
+               restartTimes[restartTimes.size() / 2], restartTimes.back());
+    }
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        const double p99 = gs.profiler.percentileMS(phase, 0.99);
+        if (p99 > 0) { // drawing phases never run
+            printf("  %-10s p50 %.3f ms, p99 %.3f ms\n", gs.profiler.getName(phase), gs.profiler.percentileMS(phase, 0.5), p99);
+        }
+    }
+    if (cfg.profileCSV && !gs.profiler.writeCSV(cfg.profileCSV)) {
+        SDL_Log("Couldn't write profile %s", cfg.profileCSV);
+    }
+    if (cfg.snapshotBench) {
+        benchSnapshots(state, gs, res, tickRate, cfg.ticks);
+    }
+}
+
+// the world of a stress run, the same cfg always makes the same one. gs.playerCount players
+void setupStressWorld(SDLState &state, GameState &gs, const Resources &res, const StressConfig &cfg, size_t bulletCap,
+                      PoolOverflow bulletOverflow, int threads) {
+    SDL_srand(cfg.seed);
+    gs.setBulletPool(bulletCap, bulletOverflow);
+    gs.particles.setCapacity(cfg.particleCap);
+    gs.streaming = cfg.streaming;
+    gs.aiLod = cfg.aiLod;
+    gs.jobs.setThreadCount(threads);
+    if (!cfg.levelPath || !loadLevelFile(state, gs, res, cfg.levelPath)) {
+        createStressLevel(state, gs, res, cfg);
+    }
+    gs.rng = cfg.seed;
+}
+
+// two peers play the stress level against each other over a loopback link with cfg's latency
+// and loss, on simulated time. both players walk the stress pattern, the second one 2 seconds
+// out of step. reports rollback depths and costs, times resimulating MAX_ROLLBACK ticks against
+// a 60 Hz frame, and checks both peers end up with the world a plain simulation of the same
+// inputs makes. 1 if they don't
+int runNetplay(SDLState &state, int tickRate, const StressConfig &cfg, size_t bulletCap, PoolOverflow bulletOverflow) {
+    Resources res;
+    res.load(state, false);
+    GameState gs(state), reference(state);
+    const uint64_t tickNS = SDL_NS_PER_SECOND / tickRate;
+    NetSession net(state, gs, cfg.netLatencyMS * SDL_NS_PER_MS, cfg.netLoss);
+    for (GameState *world : { &gs, &net.remoteGs, &reference }) {
+        world->playerCount = 2;
+        setupStressWorld(state, *world, res, cfg, bulletCap, bulletOverflow, cfg.threads);
+    }
+    const auto inputOf = [tickRate](int slot, int tick) {
+        return stressInput(tick + slot * tickRate * 2, tickRate);
+    };
+
+    const float deltaTime = 1.0f / tickRate;
+    const uint64_t start = SDL_GetTicksNS();
+    int steps = 0;
+    for (; steps < cfg.ticks * 10; steps++) {
+        const bool done = net.local.tick == cfg.ticks && net.remote.tick == cfg.ticks &&
+                          net.local.inputs.getConfirmed(1) == cfg.ticks && net.remote.inputs.getConfirmed(0) == cfg.ticks;
+        if (done || net.local.desynced || net.remote.desynced) {
+            break;
+        }
+        net.link.setTime(steps * tickNS);
+        for (NetPeer *peer : { &net.local, &net.remote }) {
+            netTick(state, *peer, res, deltaTime, inputOf(peer->localSlot, peer->tick), peer->tick < cfg.ticks);
+        }
+    }
+    const double seconds = (SDL_GetTicksNS() - start) / static_cast<double>(SDL_NS_PER_SECOND);
+    for (int tick = 0; tick < cfg.ticks; tick++) {
+        const uint8_t inputs[MAX_PLAYERS] = { inputOf(0, tick), inputOf(1, tick) };
+        stepSimulation(state, reference, res, deltaTime, inputs);
+    }
+
+    printf("map %d x %d, seed %llu, %d ticks at %d Hz on %d threads, %d ms latency, %.0f%% loss\n", gs.tiles.getCols(),
+           gs.tiles.getRows(), static_cast<unsigned long long>(cfg.seed), cfg.ticks, tickRate, gs.jobs.getThreadCount(),
+           cfg.netLatencyMS, cfg.netLoss * 100);
+    printf("%d steps of both peers in %.3f s, %d packets sent, %d lost\n", steps, seconds, net.link.getSent(), net.link.getLost());
+    for (NetPeer *peer : { &net.local, &net.remote }) {
+        std::vector<double> &times = peer->resimTimes;
+        std::sort(times.begin(), times.end());
+        const auto percentile = [&times](double p) {
+            return times.empty() ? 0 : times[static_cast<size_t>(p * (times.size() - 1))];
+        };
+        printf("peer %d: %d rollbacks, max depth %d, %d stalls, resim p50 %.3f ms, p99 %.3f ms, max %.3f ms%s\n", peer->localSlot,
+               peer->rollbacks, peer->maxDepth, peer->stalls, percentile(0.5), percentile(0.99), percentile(1.0),
+               peer->desynced ? ", desynced at a failed rollback" : "");
+    }
+
+    // the worst case a frame can get: back MAX_ROLLBACK ticks and all of them again
+    const int RUNS = 50;
+    std::vector<double> worst(RUNS);
+    WorldSnapshot snap;
+    captureSnapshot(gs, snap);
+    uint8_t inputs[MAX_PLAYERS] = { 0 };
+    for (int run = 0; run < RUNS; run++) {
+        const uint64_t runStart = SDL_GetPerformanceCounter();
+        restoreSnapshot(state, gs, snap);
+        for (int tick = 0; tick < MAX_ROLLBACK; tick++) {
+            inputs[0] = inputOf(0, cfg.ticks + tick);
+            inputs[1] = inputOf(1, cfg.ticks + tick);
+            stepSimulation(state, gs, res, deltaTime, inputs);
+        }
+        worst[run] = gs.profiler.toMS(SDL_GetPerformanceCounter() - runStart);
+    }
+    restoreSnapshot(state, gs, snap);
+    std::sort(worst.begin(), worst.end());
+    printf("%d tick rollback with %zu characters: p50 %.3f ms, max %.3f ms of a 16.667 ms frame\n", MAX_ROLLBACK,
+           gs.characters.size(), worst[RUNS / 2], worst.back());
+
+    const uint64_t expected = worldChecksum(reference);
+    const bool match = !net.local.desynced && !net.remote.desynced &&
+                       worldChecksum(gs) == expected && worldChecksum(net.remoteGs) == expected;
+    printf("peers %s the plain simulation, checksum %016llx\n", match ? "match" : "DON'T MATCH",
+           static_cast<unsigned long long>(expected));
+    return match ? 0 : 1;
+}
+
+// walk right for 4 seconds, back for 1, shoot the whole time and hop every 3/4 second
+uint8_t stressInput(int tick, int tickRate) {
+    const int phase = tick % (tickRate * 5);
+    uint8_t input = (phase < tickRate * 4 ? INPUT_RIGHT : INPUT_LEFT) | INPUT_SHOOT;
+    if (tick % std::max(tickRate * 3 / 4, 1) == 0) {
+        input |= INPUT_JUMP;
+    }
+    return input;
+}
+
+// snapshot size and capture / restore times for the world as the stress run left it, then
+// whether a restored world simulates the same ticks as the original did
+void benchSnapshots(SDLState &state, GameState &gs, Resources &res, int tickRate, int firstTick) {
+    const int RUNS = 200;
+    const int RESIMULATED_TICKS = 120;
+    WorldSnapshot snap, scratch;
+    std::vector<double> captureTimes(RUNS), restoreTimes(RUNS);
+    captureSnapshot(gs, snap);
+    for (int i = 0; i < RUNS; i++) {
+        uint64_t start = SDL_GetPerformanceCounter();
+        captureSnapshot(gs, scratch);
+        captureTimes[i] = gs.profiler.toMS(SDL_GetPerformanceCounter() - start);
+        start = SDL_GetPerformanceCounter();
+        restoreSnapshot(state, gs, snap);
+        restoreTimes[i] = gs.profiler.toMS(SDL_GetPerformanceCounter() - start);
+    }
+    std::sort(captureTimes.begin(), captureTimes.end());
+    std::sort(restoreTimes.begin(), restoreTimes.end());
+    const size_t entities = gs.characters.size() + gs.bullets.size() + gs.stream.getParkedCount();
+    printf("snapshot %zu bytes for %zu characters, %zu bullets, %zu parked (%.1f bytes / entity)\n", snap.size(),
+           gs.characters.size(), gs.bullets.size(), gs.stream.getParkedCount(), snap.size() / static_cast<double>(std::max<size_t>(entities, 1)));
+    printf("capture p50 %.1f us, max %.1f us, restore (with the broadphase rebuild) p50 %.1f us, max %.1f us\n", captureTimes[RUNS / 2] * 1000,
+           captureTimes.back() * 1000, restoreTimes[RUNS / 2] * 1000, restoreTimes.back() * 1000);
+
+    const float deltaTime = 1.0f / tickRate;
+    std::vector<uint64_t> checksums;
+    for (int tick = 0; tick < RESIMULATED_TICKS; tick++) {
+        stepSimulation(state, gs, res, deltaTime, stressInput(firstTick + tick, tickRate));
+        checksums.push_back(worldChecksum(gs));
+    }
+    if (!restoreSnapshot(state, gs, snap)) {
+        printf("restoring the snapshot failed\n");
+        return;
+    }
+    for (int tick = 0; tick < RESIMULATED_TICKS; tick++) {
+        stepSimulation(state, gs, res, deltaTime, stressInput(firstTick + tick, tickRate));
+        if (worldChecksum(gs) != checksums[tick]) {
+            printf("restored world differs from the original %d ticks after the snapshot\n", tick + 1);
+            return;
+        }
+    }
+    printf("restored world matches the original for %d ticks\n", RESIMULATED_TICKS);
+}
+
+// plays a recording from --record without a window: same level, seed and settings, then every
+// recorded tick's input as fast as the simulation goes. prints the final worldChecksum, 1 if it
+// doesn't match the one recorded
+int runReplay(SDLState &state, const char *path, int threads) {
+    InputRecording rec;
+    std::string error;
+    if (!rec.load(path, error)) {
+        SDL_Log("Couldn't load recording %s: %s", path, error.c_str());
+        return 1;
+    }
+    SDL_srand(rec.seed);
+    Resources res;
+    res.load(state, false);
+    GameState gs(state);
+    gs.rng = rec.seed;
+    gs.setBulletPool(rec.bulletCap, rec.flags & InputRecording::FLAG_RECYCLE_BULLETS ? PoolOverflow::recycle : PoolOverflow::drop);
+    gs.streaming = rec.flags & InputRecording::FLAG_STREAMING;
+    gs.aiLod = rec.flags & InputRecording::FLAG_AI_LOD;
+    gs.jobs.setThreadCount(threads);
+    if (rec.levelPath.empty()) {
+        createTiles(state, gs, res);
+    } else if (!loadLevelFile(state, gs, res, rec.levelPath.c_str())) {
+        return 1; // a different level would be a different session
+    }
+
+    // computed like the window's fixed tick, 1.0f / tickRate rounds differently and the worlds drift apart
+    const float deltaTime = (SDL_NS_PER_SECOND / rec.tickRate) / static_cast<float>(SDL_NS_PER_SECOND);
+    const uint64_t start = SDL_GetTicksNS();
+    size_t tick = 0;
+    while (tick < rec.ticks.size()) { // the recorded ticks include the ones after the player died
+        stepSimulation(state, gs, res, deltaTime, rec.ticks[tick++]);
+    }
+    const double seconds = (SDL_GetTicksNS() - start) / static_cast<double>(SDL_NS_PER_SECOND);
+    const uint64_t checksum = worldChecksum(gs);
+    printf("%zu ticks at %u Hz in %.3f s, %.1fx real time on %d threads\n", tick, rec.tickRate, seconds,
+           tick / static_cast<double>(rec.tickRate) / std::max(seconds, 1e-9), gs.jobs.getThreadCount());
+    printf("checksum %016llx, recorded %016llx: %s\n", static_cast<unsigned long long>(checksum),
+           static_cast<unsigned long long>(rec.finalChecksum), checksum == rec.finalChecksum ? "match" : "MISMATCH");
+    return checksum == rec.finalChecksum ? 0 : 1;
+}
+
+// keys the simulation reacts to, the ones heldInput reads and K
+bool isGameKey(SDL_Scancode key) {
+    return key == SDL_SCANCODE_A || key == SDL_SCANCODE_D || key == SDL_SCANCODE_J || key == SDL_SCANCODE_K;
+}
+
+// held buttons from the keyboard state, A/D move and J shoots. presses (K jumps) come from events
+uint8_t heldInput(const bool *keys) {
+    uint8_t input = 0;
+    if (keys[SDL_SCANCODE_A]) {
+        input |= INPUT_LEFT;
+    }
+    if (keys[SDL_SCANCODE_D]) {
+        input |= INPUT_RIGHT;
+    }
+    if (keys[SDL_SCANCODE_J]) {
+        input |= INPUT_SHOOT;
+    }
+    return input;
+}
+
+// FNV-1a over the simulated state of every character and bullet, equal only if the worlds match bit for bit
+uint64_t worldChecksum(GameState &gs) {
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    for (EntityStore *store : { &gs.characters, &gs.bullets }) {
+        const size_t n = store->size();
+        mix(store->pos.data(), n * sizeof(glm::vec2));
+        mix(store->vel.data(), n * sizeof(glm::vec2));
+        mix(store->collider.data(), n * sizeof(SDL_FRect));
+        mix(store->grounded.data(), n);
+        for (const GameObject &obj : store->objects) { // fields one by one, the union has padding
+            mix(&obj.type, sizeof(obj.type));
+            mix(&obj.dir, sizeof(obj.dir));
+            mix(&obj.anim.clip, sizeof(obj.anim.clip));
+            mix(&obj.anim.time, sizeof(obj.anim.time));
+            if (obj.type == ObjectType::player) {
+                mix(&obj.data.player.state, sizeof(obj.data.player.state));
+                mix(&obj.data.player.healthPoints, sizeof(obj.data.player.healthPoints));
+            } else if (obj.type == ObjectType::enemy) {
+                mix(&obj.data.enemy.state, sizeof(obj.data.enemy.state));
+                mix(&obj.data.enemy.healthPoints, sizeof(obj.data.enemy.healthPoints));
+            } else if (obj.type == ObjectType::bullet) {
+                mix(&obj.data.bullet.state, sizeof(obj.data.bullet.state));
+            }
+        }
+    }
+    return hash;
+}
+
+void handleKeyInput(const SDLState &state, GameState &gs, Entity ent,
                     SDL_Scancode key, bool keyDown) {
     const float JUMP_FORCE = -350.f;
+    GameObject &obj = ent.obj;
     if (obj.type == ObjectType::player) {
         switch (obj.data.player.state) {
             case PlayerState::idle:
             {
-                if (key == SDL_SCANCODE_K && keyDown && obj.grounded) {
+                if (key == SDL_SCANCODE_K && keyDown && ent.grounded) {
                     obj.data.player.state = PlayerState::jumping;
-                    obj.vel.y += JUMP_FORCE;
+                    ent.vel.y += JUMP_FORCE;
                 }
                 break;
             }
             case PlayerState::running:
             {
-                if (key == SDL_SCANCODE_K && keyDown && obj.grounded) {
+                if (key == SDL_SCANCODE_K && keyDown && ent.grounded) {
                     obj.data.player.state = PlayerState::jumping;
-                    obj.vel.y += JUMP_FORCE;
+                    ent.vel.y += JUMP_FORCE;
                 }
                 break;
             }
@@ -908,16 +2784,19 @@ void handleKeyInput(const SDLState &state, GameState &gs, GameObject &obj,
     }
 }
 
-void drawParallaxBackground(SDL_Renderer *renderer, SDL_Texture *texture, float xVelocity, float &scrollPos, float scrollFactor, float deltaTime) {
+void drawParallaxBackground(SpriteBatch &batch, int layer, SDL_Texture *texture, float xVelocity, float &scrollPos, float scrollFactor, float deltaTime) {
     scrollPos -= xVelocity * scrollFactor * deltaTime; // moving background to the left at rate dependent on playerX
     if (scrollPos <= -texture->w) {
         scrollPos = 0;
     }
-    SDL_FRect dst {
-        .x = scrollPos,
-        .y = 200,
-        .w = texture->w * 2.0f,
-        .h = static_cast<float>(texture->h)
-    };
-    SDL_RenderTextureTiled(renderer, texture, nullptr, 1, &dst);
-}
\ No newline at end of file
+    // two copies side by side cover the screen while scrolling
+    for (int i = 0; i < 2; i++) {
+        SDL_FRect dst {
+            .x = scrollPos + i * texture->w,
+            .y = 200,
+            .w = static_cast<float>(texture->w),
+            .h = static_cast<float>(texture->h)
+        };
+        batch.draw(layer, texture, nullptr, dst);
+    }
+}
@@ -1,27 +1,59 @@
 #pragma once
-#include "timer.h"
 
+#include <algorithm>
+
+// immutable clip, Resources owns one of each and every entity playing it shares it
 class Animation {
-    Timer timer;
     int frameCount;
+    float length;
+    float frameRate; // frames per second, precomputed so picking a frame is a multiply
 
     public:
-        Animation() : timer(0), frameCount(0) {
+        Animation() : frameCount(0), length(0), frameRate(0) {
 
         }
-        Animation(int frameCount, float length) : frameCount(frameCount), timer(length) {
+        Animation(int frameCount, float length) : frameCount(frameCount), length(length), frameRate(frameCount / length) {
 
+        }
+        int getFrameCount() const {
+            return frameCount;
         }
         float getLength() const {
-            return timer.getLength();
+            return length;
         }
-        int currentFrame() const {
-            return static_cast<int>(timer.getTime() / timer.getLength() * frameCount);
+        int frameAt(float time) const {
+            return std::min(static_cast<int>(time * frameRate), frameCount - 1);
         }
-        void step(float deltaTime) {
-            timer.step(deltaTime);
+};
+
+// per entity playback of a clip, just an id and a clock so copying it never allocates
+struct AnimationState {
+    int clip; // index into Resources::animations, -1 for none
+    float time;
+    bool done; // clip has played through at least once
+
+    AnimationState() : clip(-1), time(0), done(false) {
+
+    }
+    // switching clips restarts from the first frame, asking for the current one changes nothing
+    void play(int clip) {
+        if (this->clip != clip) {
+            this->clip = clip;
+            time = 0;
+            done = false;
         }
-        bool isDone() const {
-            return timer.isTimeOut();
+    }
+    void stop() {
+        clip = -1;
+    }
+    void step(const Animation &anim, float deltaTime) {
+        time += deltaTime;
+        if (time >= anim.getLength()) { // loop
+            time -= anim.getLength();
+            done = true;
         }
-};
\ No newline at end of file
+    }
+    int currentFrame(const Animation &anim) const {
+        return anim.frameAt(time);
+    }
+};
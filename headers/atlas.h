@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+// a rectangle of pixels inside a texture, normally a region of an atlas page
+struct Sprite {
+    SDL_Texture *texture;
+    SDL_FRect rect;
+    Sprite() : texture(nullptr), rect{ 0 } {
+
+    }
+    // rect in sprite local pixels (one animation frame etc.) to texture pixels
+    SDL_FRect sub(float x, float y, float w, float h) const {
+        return SDL_FRect {
+            .x = rect.x + x,
+            .y = rect.y + y,
+            .w = w,
+            .h = h
+        };
+    }
+};
+
+// packs images into as few page textures as possible at load time.
+// add() every surface, then build() once to create the pages and fill in the sprites
+class AtlasBuilder {
+    struct Entry {
+        SDL_Surface *surface;
+        Sprite *out;
+        int page, x, y;
+    };
+    struct Page {
+        int width, height; // height grows with the shelves
+        int shelfY, shelfHeight, cursorX;
+    };
+    int pageSize;
+    int padding; // empty pixels between images so filtering never picks up a neighbour
+    std::vector<Entry> entries;
+
+    public:
+        AtlasBuilder(int pageSize = 1024, int padding = 1) : pageSize(pageSize), padding(padding) {
+
+        }
+        // takes ownership of surface, out is filled in by build(). a null surface leaves out empty
+        void add(SDL_Surface *surface, Sprite *out) {
+            if (!surface) {
+                return;
+            }
+            entries.push_back(Entry {
+                .surface = surface,
+                .out = out,
+                .page = 0,
+                .x = 0,
+                .y = 0
+            });
+        }
+        // shelf packing, tallest images first so each shelf wastes little height.
+        // returns the page textures, the caller owns them
+        std::vector<SDL_Texture *> build(SDL_Renderer *renderer) {
+            std::vector<SDL_Texture *> textures;
+            if (entries.empty()) {
+                return textures;
+            }
+            std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+                if (a.surface->h != b.surface->h) {
+                    return a.surface->h > b.surface->h;
+                }
+                return a.surface->w > b.surface->w;
+            });
+            int size = pageSize;
+            for (const Entry &e : entries) { // an image bigger than a page gets a bigger page
+                size = std::max(size, std::max(e.surface->w, e.surface->h) + padding);
+            }
+            std::vector<Page> pages;
+            pages.push_back(Page { .width = size, .height = 0, .shelfY = 0, .shelfHeight = 0, .cursorX = 0 });
+            for (Entry &e : entries) {
+                const int w = e.surface->w + padding;
+                const int h = e.surface->h + padding;
+                Page *page = &pages.back();
+                if (page->cursorX + w > page->width) { // shelf full, open the next one below
+                    page->shelfY += page->shelfHeight;
+                    page->shelfHeight = 0;
+                    page->cursorX = 0;
+                }
+                if (page->shelfY + h > size) { // page full
+                    pages.push_back(Page { .width = size, .height = 0, .shelfY = 0, .shelfHeight = 0, .cursorX = 0 });
+                    page = &pages.back();
+                }
+                e.page = static_cast<int>(pages.size()) - 1;
+                e.x = page->cursorX;
+                e.y = page->shelfY;
+                page->cursorX += w;
+                page->shelfHeight = std::max(page->shelfHeight, h);
+                page->height = std::max(page->height, page->shelfY + page->shelfHeight);
+            }
+
+            // copy the pixels into one surface per page and upload them
+            for (size_t p = 0; p < pages.size(); p++) {
+                SDL_Surface *pageSurface = SDL_CreateSurface(pages[p].width, pages[p].height, SDL_PIXELFORMAT_RGBA32);
+                for (const Entry &e : entries) {
+                    if (e.page != static_cast<int>(p)) {
+                        continue;
+                    }
+                    SDL_Rect dst { .x = e.x, .y = e.y, .w = e.surface->w, .h = e.surface->h };
+                    SDL_SetSurfaceBlendMode(e.surface, SDL_BLENDMODE_NONE); // copy alpha as is
+                    SDL_BlitSurface(e.surface, nullptr, pageSurface, &dst);
+                }
+                SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, pageSurface);
+                SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST); // pixel perfect
+                SDL_DestroySurface(pageSurface);
+                textures.push_back(tex);
+            }
+            for (Entry &e : entries) {
+                e.out->texture = textures[e.page];
+                e.out->rect = SDL_FRect {
+                    .x = static_cast<float>(e.x),
+                    .y = static_cast<float>(e.y),
+                    .w = static_cast<float>(e.surface->w),
+                    .h = static_cast<float>(e.surface->h)
+                };
+                SDL_DestroySurface(e.surface);
+            }
+            entries.clear();
+            return textures;
+        }
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <SDL3/SDL.h>
+#include "../ext/glm/glm.hpp"
+#include "../headers/gameobject.h"
+#include "../headers/snapshot.h"
+
+// physics fields of a new entity, add() copies them into the store's arrays
+struct Body {
+    glm::vec2 pos, vel, acc;
+    SDL_FRect collider; // rectangle for collision
+    float maxSpeedX;
+    bool dynamic;
+    Body() : pos(0), vel(0), acc(0), collider{ 0 }, maxSpeedX(0), dynamic(false) {
+
+    }
+};
+
+// one entity's fields, the hot ones point into the store's arrays and the cold ones are in obj
+struct Entity {
+    GameObject &obj;
+    glm::vec2 &pos, &prevPos, &vel, &acc;
+    SDL_FRect &collider;
+    float &maxSpeedX;
+    float &moveDir;
+    uint8_t &dynamic, &grounded;
+};
+
+// structure of arrays entity storage. index i of every array belongs to the same entity,
+// so the integration pass only streams the physics fields and never touches GameObject
+class EntityStore {
+    public:
+        // hot
+        std::vector<glm::vec2> pos, prevPos, vel, acc;
+        std::vector<float> maxSpeedX;
+        std::vector<float> moveDir; // -1, 0 or 1, steering picked by the type logic this tick
+        std::vector<uint8_t> dynamic, grounded; // bytes rather than vector<bool> so the pass stays branch free
+        std::vector<SDL_FRect> collider;
+        // cold, type specific state
+        std::vector<GameObject> objects;
+
+        size_t size() const {
+            return objects.size();
+        }
+        size_t add(const Body &body, const GameObject &obj) {
+            pos.push_back(body.pos);
+            prevPos.push_back(body.pos); // nothing to interpolate from yet
+            vel.push_back(body.vel);
+            acc.push_back(body.acc);
+            maxSpeedX.push_back(body.maxSpeedX);
+            moveDir.push_back(0);
+            dynamic.push_back(body.dynamic);
+            grounded.push_back(false);
+            collider.push_back(body.collider);
+            objects.push_back(obj);
+            return objects.size() - 1;
+        }
+        // reinitialize slot i as a new entity
+        void set(size_t i, const Body &body, const GameObject &obj) {
+            pos[i] = prevPos[i] = body.pos;
+            vel[i] = body.vel;
+            acc[i] = body.acc;
+            maxSpeedX[i] = body.maxSpeedX;
+            moveDir[i] = 0;
+            dynamic[i] = body.dynamic;
+            grounded[i] = false;
+            collider[i] = body.collider;
+            objects[i] = obj;
+        }
+        // swap the last entity into slot i, O(1) but does not keep order
+        void remove(size_t i) {
+            const size_t last = size() - 1;
+            if (i != last) {
+                pos[i] = pos[last];
+                prevPos[i] = prevPos[last];
+                vel[i] = vel[last];
+                acc[i] = acc[last];
+                maxSpeedX[i] = maxSpeedX[last];
+                moveDir[i] = moveDir[last];
+                dynamic[i] = dynamic[last];
+                grounded[i] = grounded[last];
+                collider[i] = collider[last];
+                objects[i] = objects[last];
+            }
+            pos.pop_back();
+            prevPos.pop_back();
+            vel.pop_back();
+            acc.pop_back();
+            maxSpeedX.pop_back();
+            moveDir.pop_back();
+            dynamic.pop_back();
+            grounded.pop_back();
+            collider.pop_back();
+            objects.pop_back();
+        }
+        // allocate room for n entities up front so add() never reallocates below that
+        void reserve(size_t n) {
+            pos.reserve(n);
+            prevPos.reserve(n);
+            vel.reserve(n);
+            acc.reserve(n);
+            maxSpeedX.reserve(n);
+            moveDir.reserve(n);
+            dynamic.reserve(n);
+            grounded.reserve(n);
+            collider.reserve(n);
+            objects.reserve(n);
+        }
+        void clear() {
+            pos.clear();
+            prevPos.clear();
+            vel.clear();
+            acc.clear();
+            maxSpeedX.clear();
+            moveDir.clear();
+            dynamic.clear();
+            grounded.clear();
+            collider.clear();
+            objects.clear();
+        }
+        Entity operator[](size_t i) {
+            return Entity {
+                .obj = objects[i],
+                .pos = pos[i],
+                .prevPos = prevPos[i],
+                .vel = vel[i],
+                .acc = acc[i],
+                .collider = collider[i],
+                .maxSpeedX = maxSpeedX[i],
+                .moveDir = moveDir[i],
+                .dynamic = dynamic[i],
+                .grounded = grounded[i]
+            };
+        }
+        // every array as it is, GameObject included since it has no pointers in it
+        void save(SnapshotWriter &out) const {
+            out.putArray(pos);
+            out.putArray(prevPos);
+            out.putArray(vel);
+            out.putArray(acc);
+            out.putArray(maxSpeedX);
+            out.putArray(moveDir);
+            out.putArray(dynamic);
+            out.putArray(grounded);
+            out.putArray(collider);
+            out.putArray(objects);
+        }
+        // false if the snapshot is damaged or the arrays don't agree on the entity count
+        bool load(SnapshotReader &in) {
+            in.getArray(pos);
+            in.getArray(prevPos);
+            in.getArray(vel);
+            in.getArray(acc);
+            in.getArray(maxSpeedX);
+            in.getArray(moveDir);
+            in.getArray(dynamic);
+            in.getArray(grounded);
+            in.getArray(collider);
+            in.getArray(objects);
+            const size_t n = objects.size();
+            return !in.failed && pos.size() == n && prevPos.size() == n && vel.size() == n && acc.size() == n &&
+                   maxSpeedX.size() == n && moveDir.size() == n && dynamic.size() == n && grounded.size() == n &&
+                   collider.size() == n;
+        }
+        // remember positions at the start of a tick so drawing can interpolate
+        void savePositions() {
+            prevPos = pos;
+        }
+        // gravity, steering acceleration, speed clamp and movement for entities begin..end in one pass.
+        // entities don't affect each other here, so disjoint ranges can run on different threads
+        void integrate(float deltaTime, float gravity, size_t begin = 0, size_t end = SIZE_MAX) {
+            const size_t n = std::min(end, size());
+            glm::vec2 *__restrict p = pos.data();
+            glm::vec2 *__restrict v = vel.data();
+            const glm::vec2 *__restrict a = acc.data();
+            const float *__restrict maxX = maxSpeedX.data();
+            const float *__restrict dir = moveDir.data();
+            const uint8_t *__restrict dyn = dynamic.data();
+            const uint8_t *__restrict gnd = grounded.data();
+            for (size_t i = begin; i < n; i++) {
+                const float fall = static_cast<float>(dyn[i] & (gnd[i] ^ 1)); // airborne dynamic bodies only
+                glm::vec2 vi = v[i];
+                vi.y += gravity * fall * deltaTime;
+                vi += dir[i] * a[i] * deltaTime;
+                // over the limit snaps to the steering direction, a body with no steering stops
+                vi.x = std::abs(vi.x) > maxX[i] ? dir[i] * maxX[i] : vi.x;
+                v[i] = vi;
+                p[i] += vi * deltaTime;
+            }
+        }
+};
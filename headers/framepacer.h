@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+enum class PacingMode {
+    vsync, // presenting waits for the display
+    uncapped, // as fast as it goes
+    target // sleeps to a fixed frame rate, input is read after the sleep
+};
+
+// decides when the next frame starts. in target mode frames start on a fixed schedule and the
+// sleep goes before the frame instead of after it, so the events polled right after are as fresh
+// as they can be. a frame more than a whole frame late moves the schedule instead of rushing
+// the frames after it
+class FramePacer {
+    PacingMode mode;
+    uint64_t frameNS; // target mode
+    uint64_t deadline; // when the next frame starts, SDL_GetTicksNS time, 0 before the first
+
+    public:
+        FramePacer() : mode(PacingMode::vsync), frameNS(0), deadline(0) {
+
+        }
+        // fps only matters in target mode
+        void setMode(PacingMode mode, int fps) {
+            this->mode = mode;
+            frameNS = SDL_NS_PER_SECOND / std::max(fps, 1);
+            deadline = 0;
+        }
+        PacingMode getMode() const {
+            return mode;
+        }
+        int getFPS() const {
+            return static_cast<int>(SDL_NS_PER_SECOND / frameNS);
+        }
+        const char *getName() const {
+            return mode == PacingMode::vsync ? "vsync" : mode == PacingMode::uncapped ? "uncapped" : "target";
+        }
+        // sleeps until the next frame should start, returns how long in ns
+        uint64_t wait() {
+            if (mode != PacingMode::target) {
+                return 0;
+            }
+            const uint64_t now = SDL_GetTicksNS();
+            if (deadline == 0 || now > deadline + frameNS) {
+                deadline = now;
+            }
+            const uint64_t sleep = deadline > now ? deadline - now : 0;
+            if (sleep > 0) {
+                SDL_DelayPrecise(sleep); // sleeps most of it and spins the rest
+            }
+            deadline += frameNS;
+            return sleep;
+        }
+};
+
+// time from input events to the present of the first frame that shows their effect. an event
+// waits until a simulation tick takes it in, and is measured once the frame drawn after that
+// tick has been presented
+class InputLatency {
+    std::vector<uint64_t> waiting, taken; // event timestamps in SDL_GetTicksNS time
+    std::vector<float> samples; // ms
+    std::vector<float> scratch; // for percentiles
+
+    public:
+        static const int BUCKET_MS = 2; // histogram resolution
+
+        // a key down the simulation will react to, timestamp from the event
+        void event(uint64_t timestamp) {
+            waiting.push_back(timestamp);
+        }
+        // a tick ran, so it has seen every event so far
+        void tick() {
+            taken.insert(taken.end(), waiting.begin(), waiting.end());
+            waiting.clear();
+        }
+        // right after SDL_RenderPresent returned
+        void present(uint64_t now) {
+            for (uint64_t timestamp : taken) {
+                samples.push_back((now - std::min(timestamp, now)) / static_cast<float>(SDL_NS_PER_MS));
+            }
+            taken.clear();
+        }
+        size_t getCount() const {
+            return samples.size();
+        }
+        // p in 0..1
+        float percentileMS(double p) {
+            if (samples.empty()) {
+                return 0;
+            }
+            scratch = samples;
+            const size_t k = static_cast<size_t>(p * (scratch.size() - 1));
+            std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+            return scratch[k];
+        }
+        // percentiles and a text histogram
+        void print(FILE *f, const char *pacing) {
+            fprintf(f, "input to present latency, %zu key presses, %s pacing\n", samples.size(), pacing);
+            if (samples.empty()) {
+                return;
+            }
+            fprintf(f, "  p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentileMS(0.5), percentileMS(0.95),
+                    percentileMS(0.99), percentileMS(1.0));
+            std::vector<int> buckets(static_cast<size_t>(percentileMS(1.0)) / BUCKET_MS + 1);
+            for (float ms : samples) {
+                buckets[static_cast<size_t>(ms) / BUCKET_MS]++;
+            }
+            const int most = *std::max_element(buckets.begin(), buckets.end());
+            for (size_t b = 0; b < buckets.size(); b++) {
+                if (buckets[b] > 0) {
+                    fprintf(f, "  %3zu-%3zu ms %5d %s\n", b * BUCKET_MS, (b + 1) * BUCKET_MS, buckets[b],
+                            std::string(std::max(buckets[b] * 40 / most, 1), '#').c_str());
+                }
+            }
+        }
+};
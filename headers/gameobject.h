@@ -1,8 +1,8 @@
 #pragma once
 
-#include <vector>
 #include <SDL3/SDL.h>
 #include "../ext/glm/glm.hpp"
+#include "../headers/timer.h"
 #include "../headers/animation.h"
 
 enum class PlayerState {
@@ -20,10 +20,12 @@ struct PlayerData {
     Timer weaponTimer;
     Timer deathTimer;
     int healthPoints;
+    int slot; // which player this is, picks the input out of GameState::inputs
     PlayerData() : weaponTimer(0.3f), deathTimer(3.0f)
     {
         state = PlayerState::idle;
         healthPoints = 1;
+        slot = 0;
     }
 };
 struct LevelData {};
@@ -31,8 +33,14 @@ struct EnemyData {
     EnemyState state;
     Timer damagedTimer;
     int healthPoints;
+    bool aware; // the player is close, set by the AI scheduler every tick
+    float skippedTime; // seconds of ticks the AI scheduler skipped, caught up by the next update
+    int target; // player slot it goes after while aware
     EnemyData() : state(EnemyState::idle), damagedTimer(0.5f) {
         healthPoints = 3;
+        aware = false;
+        skippedTime = 0;
+        target = 0;
     }
 };
 struct BulletData {
@@ -54,31 +62,22 @@ enum class ObjectType {
     player, level, enemy, bullet
 };
 
+// type specific state of an entity. the physics fields (position, velocity, collider...)
+// live in EntityStore's arrays at the same index
 struct GameObject {
     ObjectType type;
     ObjectData data;
-    glm::vec2 pos, vel, acc;
     float dir;
-    float maxSpeedX;
-    std::vector<Animation> animations;
-    int curAnimation;
-    SDL_Texture *texture;
-    bool dynamic;
-    bool grounded;
-    SDL_FRect collider; // rectangle for collision
+    AnimationState anim;
+    int sprite; // index into Resources::sprites
     Timer flashTimer;
     bool shouldFlash;
     int spriteFrame;
-    GameObject() : data{.level = LevelData()}, collider{ 0 }, flashTimer(0.05f)
+    GameObject() : data{.level = LevelData()}, flashTimer(0.05f)
     {
         type = ObjectType::level;
         dir = 1;
-        maxSpeedX = 0;
-        pos = vel = acc = glm::vec2(0);
-        curAnimation = -1;
-        texture = nullptr;
-        dynamic = false;
-        grounded = false;
+        sprite = 0;
         shouldFlash = false;   
         spriteFrame = 1;
     }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// buttons of one simulation tick, held ones are sampled once per frame, pressed ones are key
+// down events since the previous tick
+const uint8_t INPUT_LEFT = 1 << 0;
+const uint8_t INPUT_RIGHT = 1 << 1;
+const uint8_t INPUT_SHOOT = 1 << 2;
+const uint8_t INPUT_JUMP = 1 << 3; // pressed
+
+// everything needed to play a session again tick for tick: how the world was set up, the rng
+// seed and the input of every tick. little endian file:
+//   "INPR", version, tickRate, bulletCap, flags, uint64 seed, uint64 finalChecksum,
+//   uint32 level path length + the path (empty for the built in level),
+//   uint32 tick count, then runs of (uint8 input, uint16 ticks) until every tick is covered
+class InputRecording {
+    static const uint32_t VERSION = 2;
+
+    public:
+        static const uint32_t FLAG_STREAMING = 1 << 0;
+        static const uint32_t FLAG_RECYCLE_BULLETS = 1 << 1; // bullet pool overflow policy
+        static const uint32_t FLAG_AI_LOD = 1 << 2;
+
+        uint32_t tickRate;
+        uint32_t bulletCap;
+        uint32_t flags;
+        uint64_t seed;
+        uint64_t finalChecksum; // worldChecksum after the last tick, for replays to compare against
+        std::string levelPath;
+        std::vector<uint8_t> ticks; // one input per tick
+
+        InputRecording() : tickRate(0), bulletCap(0), flags(0), seed(0), finalChecksum(0) {
+
+        }
+        bool save(const char *path) const {
+            std::vector<uint8_t> out;
+            const auto put = [&out](uint64_t value, int bytes) {
+                for (int i = 0; i < bytes; i++) {
+                    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+                }
+            };
+            out.insert(out.end(), { 'I', 'N', 'P', 'R' });
+            put(VERSION, 4);
+            put(tickRate, 4);
+            put(bulletCap, 4);
+            put(flags, 4);
+            put(seed, 8);
+            put(finalChecksum, 8);
+            put(levelPath.size(), 4);
+            out.insert(out.end(), levelPath.begin(), levelPath.end());
+            put(ticks.size(), 4);
+            for (size_t i = 0; i < ticks.size();) { // input rarely changes between ticks, so run length encode
+                size_t run = 1;
+                while (i + run < ticks.size() && ticks[i + run] == ticks[i] && run < UINT16_MAX) {
+                    run++;
+                }
+                put(ticks[i], 1);
+                put(run, 2);
+                i += run;
+            }
+            FILE *f = fopen(path, "wb");
+            if (!f) {
+                return false;
+            }
+            const bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+            return fclose(f) == 0 && ok;
+        }
+        // false with a reason in error if the file is missing, damaged or from another version
+        bool load(const char *path, std::string &error) {
+            FILE *f = fopen(path, "rb");
+            if (!f) {
+                error = "can't open file";
+                return false;
+            }
+            std::vector<uint8_t> in;
+            uint8_t buffer[4096];
+            for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0;) {
+                in.insert(in.end(), buffer, buffer + n);
+            }
+            fclose(f);
+            size_t at = 0;
+            bool truncated = false;
+            const auto get = [&](int bytes) {
+                uint64_t value = 0;
+                if (at + bytes > in.size()) {
+                    truncated = true;
+                    return value;
+                }
+                for (int i = 0; i < bytes; i++) {
+                    value |= static_cast<uint64_t>(in[at++]) << (8 * i);
+                }
+                return value;
+            };
+            if (in.size() < 8 || memcmp(in.data(), "INPR", 4) != 0) {
+                error = "not an input recording";
+                return false;
+            }
+            at = 4;
+            const uint32_t version = static_cast<uint32_t>(get(4));
+            if (version != VERSION) {
+                error = "unsupported version " + std::to_string(version);
+                return false;
+            }
+            tickRate = static_cast<uint32_t>(get(4));
+            bulletCap = static_cast<uint32_t>(get(4));
+            flags = static_cast<uint32_t>(get(4));
+            seed = get(8);
+            finalChecksum = get(8);
+            const size_t pathLength = static_cast<size_t>(get(4));
+            if (truncated || at + pathLength > in.size()) {
+                error = "truncated";
+                return false;
+            }
+            levelPath.assign(in.begin() + at, in.begin() + at + pathLength);
+            at += pathLength;
+            const size_t tickCount = static_cast<size_t>(get(4));
+            ticks.clear();
+            while (!truncated && ticks.size() < tickCount) {
+                const uint8_t input = static_cast<uint8_t>(get(1));
+                const size_t run = static_cast<size_t>(get(2));
+                ticks.insert(ticks.end(), std::min(run, tickCount - ticks.size()), input);
+            }
+            if (truncated || tickRate == 0) {
+                error = truncated ? "truncated" : "no tick rate";
+                return false;
+            }
+            return true;
+        }
+};
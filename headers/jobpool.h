@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+// work stealing thread pool for data parallel loops. parallelFor splits the index range into
+// chunks dealt out to one queue per thread, each thread works through its own queue from the
+// back and steals from the front of the others once it runs dry. the calling thread takes part,
+// so a pool of one thread runs everything inline
+class JobPool {
+    struct Range {
+        size_t begin, end;
+    };
+    struct Queue {
+        std::mutex lock;
+        std::deque<Range> ranges;
+    };
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues; // queue 0 belongs to the calling thread
+    std::function<void(size_t, size_t, int)> job; // the running parallelFor's body
+    std::atomic<size_t> remaining; // chunks of the running parallelFor not finished yet
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    uint64_t generation; // bumped for every parallelFor, workers sleep until it changes
+    bool quitting;
+
+    bool take(int self, Range &out) {
+        { // newest chunk of our own first, it's the one most likely still in cache
+            Queue &own = *queues[self];
+            std::lock_guard<std::mutex> hold(own.lock);
+            if (!own.ranges.empty()) {
+                out = own.ranges.back();
+                own.ranges.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) { // steal the oldest chunk of someone else
+            Queue &other = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> hold(other.lock);
+            if (!other.ranges.empty()) {
+                out = other.ranges.front();
+                other.ranges.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    void work(int self) {
+        Range r;
+        while (take(self, r)) {
+            job(r.begin, r.end, self);
+            remaining--;
+        }
+    }
+    void workerLoop(int self) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> hold(wakeLock);
+                wake.wait(hold, [this, seen]() { return quitting || generation != seen; });
+                if (quitting) {
+                    return;
+                }
+                seen = generation;
+            }
+            work(self);
+        }
+    }
+    void stop() {
+        {
+            std::lock_guard<std::mutex> hold(wakeLock);
+            quitting = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        quitting = false;
+    }
+
+    public:
+        JobPool() : remaining(0), generation(0), quitting(false) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        JobPool(const JobPool &) = delete;
+        JobPool &operator=(const JobPool &) = delete;
+        ~JobPool() {
+            stop();
+        }
+        // threads includes the caller, 0 uses every hardware thread
+        void setThreadCount(int threads) {
+            if (threads <= 0) {
+                threads = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+            }
+            stop();
+            queues.clear();
+            for (int i = 0; i < threads; i++) {
+                queues.push_back(std::make_unique<Queue>());
+            }
+            for (int i = 1; i < threads; i++) {
+                workers.emplace_back(&JobPool::workerLoop, this, i);
+            }
+        }
+        int getThreadCount() const {
+            return static_cast<int>(queues.size());
+        }
+        // calls fn(begin, end, thread) over 0..count in chunks of at most grain indices and returns
+        // once all of them ran. thread is 0..getThreadCount() - 1, for per thread scratch. chunks
+        // may run in any order on any thread, so fn must only write what its own indices own
+        template <typename F>
+        void parallelFor(size_t count, size_t grain, F &&fn) {
+            if (count == 0) {
+                return;
+            }
+            grain = std::max<size_t>(grain, 1);
+            if (workers.empty() || count <= grain) {
+                fn(static_cast<size_t>(0), count, 0);
+                return;
+            }
+            job = fn;
+            const size_t chunks = (count + grain - 1) / grain;
+            remaining = chunks;
+            for (size_t k = 0; k < chunks; k++) {
+                Queue &q = *queues[k % queues.size()];
+                std::lock_guard<std::mutex> hold(q.lock);
+                q.ranges.push_back(Range { .begin = k * grain, .end = std::min((k + 1) * grain, count) });
+            }
+            {
+                std::lock_guard<std::mutex> hold(wakeLock);
+                generation++;
+            }
+            wake.notify_all();
+            work(0);
+            while (remaining > 0) { // the last chunks are finishing on other threads
+                std::this_thread::yield();
+            }
+        }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../headers/mappedfile.h"
+
+// level file layout, little endian, every section 8 byte aligned:
+//   LevelHeader
+//   layerCount tile layers of rows * cols tile ids, one byte each, column major so the columns
+//   around the camera are one contiguous run
+//   spawnCount LevelSpawn records
+// tile layers are used straight from the mapping, nothing is parsed per tile
+const char LEVEL_MAGIC[4] = { 'L', 'V', 'L', 'F' };
+const uint32_t LEVEL_VERSION = 1;
+
+enum LevelLayer {
+    LEVEL_LAYER_SOLID, // collides
+    LEVEL_LAYER_BACK, // decoration behind the characters
+    LEVEL_LAYER_FRONT, // decoration in front of them
+    LEVEL_LAYER_COUNT
+};
+enum class SpawnKind : uint32_t {
+    player, enemy
+};
+
+struct LevelHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t rows, cols;
+    uint32_t layerCount;
+    uint32_t spawnCount;
+    uint64_t layersOffset; // layer i starts at layersOffset + i * rows * cols
+    uint64_t spawnsOffset;
+};
+struct LevelSpawn {
+    SpawnKind kind;
+    uint32_t row, col;
+};
+
+// a level file mapped and checked, the layers point into the mapping
+class LevelFile {
+    MappedFile file;
+    const LevelHeader *header;
+
+    public:
+        LevelFile() : header(nullptr) {
+
+        }
+        // false with a reason in error if the file is missing, truncated or from another version
+        bool open(const char *path, std::string &error) {
+            header = nullptr;
+            if (!file.open(path)) {
+                error = "can't open file";
+                return false;
+            }
+            if (file.size() < sizeof(LevelHeader)) {
+                error = "file too small";
+                return false;
+            }
+            const LevelHeader *h = reinterpret_cast<const LevelHeader *>(file.data());
+            if (memcmp(h->magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0) {
+                error = "not a level file";
+                return false;
+            }
+            if (h->version != LEVEL_VERSION) {
+                error = "unsupported version " + std::to_string(h->version);
+                return false;
+            }
+            const uint64_t layerSize = static_cast<uint64_t>(h->rows) * h->cols;
+            if (h->layerCount < LEVEL_LAYER_COUNT || layerSize == 0 ||
+                h->layersOffset + layerSize * h->layerCount > file.size() ||
+                h->spawnsOffset % alignof(LevelSpawn) != 0 ||
+                h->spawnsOffset + static_cast<uint64_t>(h->spawnCount) * sizeof(LevelSpawn) > file.size()) {
+                error = "sections out of range";
+                return false;
+            }
+            header = h;
+            return true;
+        }
+        void close() {
+            header = nullptr;
+            file.close();
+        }
+        bool isOpen() const {
+            return header;
+        }
+        int rows() const {
+            return header->rows;
+        }
+        int cols() const {
+            return header->cols;
+        }
+        uint8_t *layer(int i) const {
+            return file.data() + header->layersOffset + static_cast<uint64_t>(i) * header->rows * header->cols;
+        }
+        // columns c0..c1 - 1 of every layer are out of use, let their pages go
+        void discardColumns(int c0, int c1) {
+            const uint64_t layerSize = static_cast<uint64_t>(header->rows) * header->cols;
+            for (uint32_t i = 0; i < header->layerCount; i++) {
+                file.discard(header->layersOffset + i * layerSize + static_cast<uint64_t>(c0) * header->rows,
+                             static_cast<uint64_t>(c1 - c0) * header->rows);
+            }
+        }
+        const LevelSpawn *spawns() const {
+            return reinterpret_cast<const LevelSpawn *>(file.data() + header->spawnsOffset);
+        }
+        int spawnCount() const {
+            return header->spawnCount;
+        }
+};
+
+// writes a level, layers[i] holds rows * cols column major tile ids
+inline bool writeLevel(const char *path, int rows, int cols, const uint8_t *const layers[LEVEL_LAYER_COUNT],
+                       const std::vector<LevelSpawn> &spawns) {
+    const auto align = [](uint64_t offset) {
+        return (offset + 7) & ~static_cast<uint64_t>(7);
+    };
+    const uint64_t layerSize = static_cast<uint64_t>(rows) * cols;
+    LevelHeader header;
+    memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version = LEVEL_VERSION;
+    header.rows = rows;
+    header.cols = cols;
+    header.layerCount = LEVEL_LAYER_COUNT;
+    header.spawnCount = static_cast<uint32_t>(spawns.size());
+    header.layersOffset = align(sizeof(LevelHeader));
+    header.spawnsOffset = align(header.layersOffset + layerSize * LEVEL_LAYER_COUNT);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    const uint8_t zeros[8] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(zeros, 1, header.layersOffset - sizeof(header), f) == header.layersOffset - sizeof(header);
+    for (int i = 0; i < LEVEL_LAYER_COUNT && ok; i++) {
+        ok = fwrite(layers[i], 1, layerSize, f) == layerSize;
+    }
+    const uint64_t pad = header.spawnsOffset - header.layersOffset - layerSize * LEVEL_LAYER_COUNT;
+    ok = ok && fwrite(zeros, 1, pad, f) == pad;
+    ok = ok && (spawns.empty() || fwrite(spawns.data(), sizeof(LevelSpawn), spawns.size(), f) == spawns.size());
+    return fclose(f) == 0 && ok;
+}
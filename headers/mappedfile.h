@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// read only file mapped into memory. the view is copy on write, so writing to it changes this
+// process' copy and never the file. pages are only read from disk once they are touched
+class MappedFile {
+    uint8_t *bytes;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
+
+    public:
+        MappedFile() : bytes(nullptr), length(0) {
+#ifdef _WIN32
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+#endif
+        }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile() {
+            close();
+        }
+        bool open(const char *path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                close();
+                return false;
+            }
+            mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+            if (!mapping) {
+                close();
+                return false;
+            }
+            bytes = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+            length = static_cast<size_t>(size.QuadPart);
+#else
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                return false;
+            }
+            void *view = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping keeps the file alive
+            bytes = view == MAP_FAILED ? nullptr : static_cast<uint8_t *>(view);
+            length = static_cast<size_t>(st.st_size);
+#endif
+            if (!bytes) {
+                close();
+                return false;
+            }
+            return true;
+        }
+        void close() {
+#ifdef _WIN32
+            if (bytes) {
+                UnmapViewOfFile(bytes);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+#else
+            if (bytes) {
+                munmap(bytes, length);
+            }
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+        // hint that bytes offset..offset + length won't be read for a while. whole pages inside
+        // the range may be dropped from memory, they are read from the file again when touched
+        void discard(size_t offset, size_t length) {
+            if (!bytes || offset >= this->length) {
+                return;
+            }
+            length = std::min(length, this->length - offset);
+#ifdef _WIN32
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            const size_t page = info.dwPageSize;
+#else
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+            const size_t begin = (offset + page - 1) / page * page;
+            const size_t end = (offset + length) / page * page;
+            if (begin >= end) {
+                return;
+            }
+#ifdef _WIN32
+            VirtualUnlock(bytes + begin, end - begin); // on pages that aren't locked this trims them from the working set
+#else
+            madvise(bytes + begin, end - begin, MADV_DONTNEED); // nothing is written to the view, so nothing is lost
+#endif
+        }
+        uint8_t *data() const {
+            return bytes;
+        }
+        size_t size() const {
+            return length;
+        }
+};
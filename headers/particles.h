@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <SDL3/SDL.h>
+#include "../headers/rendercapture.h"
+#include "../ext/glm/glm.hpp"
+
+// how one emit() call spreads its particles
+struct ParticleBurst {
+    int count;
+    float speed; // upper bound, each particle gets between half and all of it
+    float spread; // radians around the direction, a zero direction throws them every way
+    float life; // seconds, each particle gets between half and all of it
+    float size; // pixels, square
+    SDL_FColor color; // alpha fades to 0 over the life
+};
+
+// short lived visual effects in structure of arrays storage with a fixed capacity, allocated up
+// front. particles never touch the simulation: they have their own random numbers and are not
+// part of the world checksum, so effects can change without breaking replays
+class ParticleSystem {
+    std::vector<float> x, y, vx, vy, life, invMaxLife;
+    std::vector<float> sizes;
+    std::vector<SDL_FColor> color;
+    size_t count;
+    int dropped; // emits lost to a full pool
+    bool muted; // emit does nothing, for ticks that are simulated again
+    uint32_t rng;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices; // the same quad pattern over and over, only ever grows
+
+    float random() { // xorshift, 0..1
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return (rng >> 8) * (1.0f / 16777216.0f);
+    }
+
+    public:
+        ParticleSystem() : count(0), dropped(0), muted(false), rng(0x9e3779b9u) {
+
+        }
+        // forgets every live particle
+        void setCapacity(size_t capacity) {
+            for (std::vector<float> *v : { &x, &y, &vx, &vy, &life, &invMaxLife, &sizes }) {
+                v->assign(capacity, 0);
+            }
+            color.assign(capacity, SDL_FColor { 0 });
+            count = 0;
+        }
+        size_t getCapacity() const {
+            return x.size();
+        }
+        size_t size() const {
+            return count;
+        }
+        int getDropped() const {
+            return dropped;
+        }
+        void clear() {
+            count = 0;
+        }
+        void setMuted(bool muted) {
+            this->muted = muted;
+        }
+        // burst.count particles at pos heading along dir
+        void emit(glm::vec2 pos, glm::vec2 dir, const ParticleBurst &burst) {
+            if (muted) {
+                return;
+            }
+            const float base = dir.x != 0 || dir.y != 0 ? SDL_atan2f(dir.y, dir.x) : 0;
+            const float spread = dir.x != 0 || dir.y != 0 ? burst.spread : 2 * SDL_PI_F;
+            for (int k = 0; k < burst.count; k++) {
+                if (count == getCapacity()) {
+                    dropped += burst.count - k;
+                    return;
+                }
+                const size_t i = count++;
+                const float angle = base + (random() - 0.5f) * spread;
+                const float speed = burst.speed * (0.5f + 0.5f * random());
+                const float lifetime = burst.life * (0.5f + 0.5f * random());
+                x[i] = pos.x;
+                y[i] = pos.y;
+                vx[i] = SDL_cosf(angle) * speed;
+                vy[i] = SDL_sinf(angle) * speed;
+                life[i] = lifetime;
+                invMaxLife[i] = 1 / lifetime;
+                sizes[i] = burst.size;
+                color[i] = burst.color;
+            }
+        }
+        // moves every particle and retires the ones that ran out of life. the first loop only
+        // streams plain float arrays with no branches so the compiler can vectorize it
+        void update(float deltaTime, float gravity) {
+            float *__restrict px = x.data();
+            float *__restrict py = y.data();
+            const float *__restrict pvx = vx.data();
+            float *__restrict pvy = vy.data();
+            float *__restrict plife = life.data();
+            const float fall = gravity * deltaTime;
+            for (size_t i = 0; i < count; i++) {
+                pvy[i] += fall;
+                px[i] += pvx[i] * deltaTime;
+                py[i] += pvy[i] * deltaTime;
+                plife[i] -= deltaTime;
+            }
+            for (size_t i = 0; i < count;) {
+                if (life[i] > 0) {
+                    i++;
+                    continue;
+                }
+                // the last particle moves into i, check it next
+                count--;
+                x[i] = x[count];
+                y[i] = y[count];
+                vx[i] = vx[count];
+                vy[i] = vy[count];
+                life[i] = life[count];
+                invMaxLife[i] = invMaxLife[count];
+                sizes[i] = sizes[count];
+                color[i] = color[count];
+            }
+        }
+        // every particle inside viewport as untextured quads in a single SDL_RenderGeometry call,
+        // alpha blended over whatever was drawn before. recorded into capture when there is one
+        void draw(SDL_Renderer *renderer, const SDL_FRect &viewport, RenderCapture *capture = nullptr) {
+            if (vertices.size() < count * 4) {
+                vertices.resize(count * 4);
+            }
+            const float left = viewport.x, top = viewport.y;
+            const float right = viewport.x + viewport.w, bottom = viewport.y + viewport.h;
+            SDL_Vertex *out = vertices.data(); // written in place, push_back costs more than the quads
+            for (size_t i = 0; i < count; i++) {
+                if (x[i] + sizes[i] < left || x[i] > right || y[i] + sizes[i] < top || y[i] > bottom) {
+                    continue;
+                }
+                SDL_FColor c = color[i];
+                c.a *= life[i] * invMaxLife[i];
+                const float x0 = x[i] - left, y0 = y[i] - top;
+                const float x1 = x0 + sizes[i], y1 = y0 + sizes[i];
+                out[0] = SDL_Vertex { { x0, y0 }, c, { 0, 0 } };
+                out[1] = SDL_Vertex { { x1, y0 }, c, { 0, 0 } };
+                out[2] = SDL_Vertex { { x1, y1 }, c, { 0, 0 } };
+                out[3] = SDL_Vertex { { x0, y1 }, c, { 0, 0 } };
+                out += 4;
+            }
+            const int quads = static_cast<int>((out - vertices.data()) / 4);
+            if (quads == 0) {
+                return;
+            }
+            for (int q = static_cast<int>(indices.size() / 6); q < quads; q++) {
+                const int quadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+                for (int i : quadIndices) {
+                    indices.push_back(q * 4 + i);
+                }
+            }
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+            SDL_RenderGeometry(renderer, nullptr, vertices.data(), quads * 4, indices.data(), quads * 6);
+            if (capture) {
+                capture->geometry(renderer, nullptr, vertices.data(), quads * 4, indices.data(), quads * 6);
+            }
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        }
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <initializer_list>
+#include <SDL3/SDL.h>
+
+// per phase frame timings for the last capacity frames. the main thread adds time to phases
+// (see lap) and closes each frame with endFrame, which publishes it into a ring buffer.
+// there is a single writer and no lock: readers on other threads see every frame that was
+// published and not yet overwritten, as long as they keep within capacity frames of the writer
+class FrameProfiler {
+    public:
+        static const int MAX_PHASES = 16;
+
+        struct Frame {
+            uint64_t phases[MAX_PHASES]; // performance counter ticks
+            uint64_t total; // whole frame, phases plus whatever wasn't measured
+        };
+
+    private:
+        std::vector<const char *> names;
+        std::vector<Frame> ring;
+        std::atomic<uint64_t> published; // frames written so far, the newest is at (published - 1) % capacity
+        Frame current;
+        uint64_t frameStart;
+        double msPerTick;
+        std::vector<float> scratch; // for percentiles
+
+        // frames are read relative to one snapshot of published so a reader never sees the ring shift under it
+        const Frame &frameAt(uint64_t newest, size_t age) const {
+            return ring[(newest - 1 - age) % ring.size()];
+        }
+
+    public:
+        FrameProfiler(std::initializer_list<const char *> names, size_t capacity = 1000) :
+            names(names), ring(std::max<size_t>(capacity, 1)), published(0), current{}, frameStart(SDL_GetPerformanceCounter()),
+            msPerTick(1000.0 / SDL_GetPerformanceFrequency()) {
+            SDL_assert(this->names.size() <= MAX_PHASES);
+        }
+        // forgets every frame, capacity is how many are kept from now on
+        void reset(size_t capacity) {
+            ring.assign(std::max<size_t>(capacity, 1), Frame{});
+            published = 0;
+            current = Frame{};
+            frameStart = SDL_GetPerformanceCounter();
+        }
+        void add(int phase, uint64_t ticks) {
+            current.phases[phase] += ticks;
+        }
+        // adds the time since start to phase and returns now, so back to back phases can chain
+        uint64_t lap(int phase, uint64_t start) {
+            const uint64_t now = SDL_GetPerformanceCounter();
+            current.phases[phase] += now - start;
+            return now;
+        }
+        // publishes the frame since the last call and starts the next one
+        void endFrame() {
+            const uint64_t now = SDL_GetPerformanceCounter();
+            current.total = now - frameStart;
+            frameStart = now;
+            const uint64_t n = published.load(std::memory_order_relaxed);
+            ring[n % ring.size()] = current;
+            published.store(n + 1, std::memory_order_release);
+            current = Frame{};
+        }
+        int getPhaseCount() const {
+            return static_cast<int>(names.size());
+        }
+        const char *getName(int phase) const {
+            return names[phase];
+        }
+        // frames that can be read, at most the capacity
+        size_t getFrameCount() const {
+            return static_cast<size_t>(std::min<uint64_t>(published.load(std::memory_order_acquire), ring.size()));
+        }
+        // age 0 is the newest frame
+        const Frame &getFrame(size_t age) const {
+            return frameAt(published.load(std::memory_order_acquire), age);
+        }
+        double toMS(uint64_t ticks) const {
+            return ticks * msPerTick;
+        }
+        // p in 0..1 over the kept frames, phase -1 for the whole frame
+        double percentileMS(int phase, double p) {
+            const uint64_t newest = published.load(std::memory_order_acquire);
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(newest, ring.size()));
+            if (n == 0) {
+                return 0;
+            }
+            scratch.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                const Frame &f = frameAt(newest, i);
+                scratch[i] = static_cast<float>(toMS(phase < 0 ? f.total : f.phases[phase]));
+            }
+            const size_t k = static_cast<size_t>(p * (n - 1));
+            std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+            return scratch[k];
+        }
+        // one row per kept frame, oldest first, times in milliseconds
+        bool writeCSV(const char *path) const {
+            FILE *f = fopen(path, "w");
+            if (!f) {
+                return false;
+            }
+            fprintf(f, "frame");
+            for (const char *name : names) {
+                fprintf(f, ",%s", name);
+            }
+            fprintf(f, ",total\n");
+            const uint64_t newest = published.load(std::memory_order_acquire);
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(newest, ring.size()));
+            for (size_t age = n; age-- > 0;) {
+                const Frame &frame = frameAt(newest, age);
+                fprintf(f, "%llu", static_cast<unsigned long long>(newest - 1 - age));
+                for (size_t i = 0; i < names.size(); i++) {
+                    fprintf(f, ",%.4f", toMS(frame.phases[i]));
+                }
+                fprintf(f, ",%.4f\n", toMS(frame.total));
+            }
+            return fclose(f) == 0;
+        }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <SDL3/SDL.h>
+#include "../headers/snapshot.h"
+
+// the render commands of some frames as the game issued them, so renderreplay.cpp can issue them
+// again against any renderer backend without the game. flip, source rects and color mods are in
+// the vertices already, SpriteBatch bakes them into texture coordinates and vertex colors.
+// textures are ids with their size and state but no pixels: what a draw costs doesn't depend on
+// what the texture shows, so the replay fills them with a pattern. baking tile chunks isn't
+// recorded, to the frames the chunks are textures like any other. file layout:
+//   Header, then textures, commands, vertices and indices as uint32 count + elements.
+// structs are written as they are in memory like in WorldSnapshot, so a capture only loads in a
+// build with the same layout
+class RenderCapture {
+    public:
+        static const uint32_t VERSION = 1;
+
+        enum Kind : uint32_t {
+            CMD_CLEAR, // to color
+            CMD_GEOMETRY, // SDL_RenderGeometry with texture, -1 for none
+            CMD_FRAME_END // where the game presented
+        };
+        struct Command {
+            uint32_t kind;
+            int32_t texture; // index into textures
+            uint32_t blend; // SDL_BlendMode in effect, the texture's or the draw blend mode without one
+            SDL_FColor color; // clear color
+            uint32_t firstVertex, vertexCount;
+            uint32_t firstIndex, indexCount; // indices count from firstVertex
+        };
+        struct TextureInfo {
+            int32_t w, h;
+            uint32_t blend; // SDL_BlendMode
+            uint32_t scaleMode; // SDL_ScaleMode
+        };
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t layout; // see WorldSnapshot::layoutOf
+            int32_t logW, logH; // size of the frames
+            uint32_t frames;
+        };
+
+        int logW, logH;
+        uint32_t frames;
+        std::vector<TextureInfo> textures;
+        std::vector<Command> commands;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+
+    private:
+        std::unordered_map<SDL_Texture *, int32_t> ids; // while recording, textures by first use
+
+        static uint32_t layout() {
+            return WorldSnapshot::layoutOf({ sizeof(Header), sizeof(Command), sizeof(TextureInfo), sizeof(SDL_Vertex) });
+        }
+        int32_t idOf(SDL_Texture *texture) {
+            if (!texture) {
+                return -1;
+            }
+            const auto found = ids.find(texture);
+            if (found != ids.end()) {
+                return found->second;
+            }
+            float w = 0, h = 0;
+            SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+            SDL_ScaleMode scaleMode = SDL_SCALEMODE_NEAREST;
+            SDL_GetTextureSize(texture, &w, &h);
+            SDL_GetTextureBlendMode(texture, &blend);
+            SDL_GetTextureScaleMode(texture, &scaleMode);
+            textures.push_back(TextureInfo { .w = static_cast<int32_t>(w), .h = static_cast<int32_t>(h),
+                                             .blend = static_cast<uint32_t>(blend), .scaleMode = static_cast<uint32_t>(scaleMode) });
+            const int32_t id = static_cast<int32_t>(textures.size() - 1);
+            ids[texture] = id;
+            return id;
+        }
+
+    public:
+        RenderCapture() : logW(0), logH(0), frames(0) {
+
+        }
+        // drops what was recorded before, the next frame is the first of a new capture
+        void begin(int logW, int logH) {
+            this->logW = logW;
+            this->logH = logH;
+            frames = 0;
+            textures.clear();
+            commands.clear();
+            vertices.clear();
+            indices.clear();
+            ids.clear();
+        }
+        // right after SDL_RenderClear
+        void clear(SDL_Renderer *renderer) {
+            SDL_FColor color { 0, 0, 0, 1 };
+            SDL_GetRenderDrawColorFloat(renderer, &color.r, &color.g, &color.b, &color.a);
+            commands.push_back(Command { .kind = CMD_CLEAR, .texture = -1, .blend = SDL_BLENDMODE_NONE, .color = color,
+                                         .firstVertex = 0, .vertexCount = 0, .firstIndex = 0, .indexCount = 0 });
+        }
+        // with the arguments of an SDL_RenderGeometry call, while the renderer state it ran with is still set
+        void geometry(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Vertex *vertexData, int vertexCount,
+                      const int *indexData, int indexCount) {
+            SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+            if (texture) {
+                SDL_GetTextureBlendMode(texture, &blend);
+            } else {
+                SDL_GetRenderDrawBlendMode(renderer, &blend);
+            }
+            commands.push_back(Command { .kind = CMD_GEOMETRY, .texture = idOf(texture), .blend = static_cast<uint32_t>(blend),
+                                         .color = SDL_FColor { 1, 1, 1, 1 },
+                                         .firstVertex = static_cast<uint32_t>(vertices.size()), .vertexCount = static_cast<uint32_t>(vertexCount),
+                                         .firstIndex = static_cast<uint32_t>(indices.size()), .indexCount = static_cast<uint32_t>(indexCount) });
+            vertices.insert(vertices.end(), vertexData, vertexData + vertexCount);
+            indices.insert(indices.end(), indexData, indexData + indexCount);
+        }
+        // right after SDL_RenderPresent
+        void endFrame() {
+            commands.push_back(Command { .kind = CMD_FRAME_END, .texture = -1, .blend = SDL_BLENDMODE_NONE, .color = SDL_FColor { 0, 0, 0, 0 },
+                                         .firstVertex = 0, .vertexCount = 0, .firstIndex = 0, .indexCount = 0 });
+            frames++;
+        }
+        bool save(const char *path) const {
+            WorldSnapshot file;
+            SnapshotWriter out(file.bytes);
+            Header header { .magic = { 'R', 'C', 'A', 'P' }, .version = VERSION, .layout = layout(),
+                            .logW = logW, .logH = logH, .frames = frames };
+            out.put(header);
+            out.putArray(textures);
+            out.putArray(commands);
+            out.putArray(vertices);
+            out.putArray(indices);
+            return file.save(path);
+        }
+        // false with a reason in error if the file is missing, damaged, from another version or
+        // points outside its own arrays
+        bool load(const char *path, std::string &error) {
+            WorldSnapshot file;
+            if (!file.load(path, error)) {
+                return false;
+            }
+            SnapshotReader in(file.bytes);
+            Header header;
+            if (!in.get(header) || memcmp(header.magic, "RCAP", 4) != 0) {
+                error = "not a render capture";
+                return false;
+            }
+            if (header.version != VERSION || header.layout != layout()) {
+                error = "made by another version or build";
+                return false;
+            }
+            in.getArray(textures);
+            in.getArray(commands);
+            in.getArray(vertices);
+            in.getArray(indices);
+            if (in.failed || !in.atEnd()) {
+                error = "truncated";
+                return false;
+            }
+            for (const Command &cmd : commands) {
+                const bool inRange = cmd.texture < static_cast<int32_t>(textures.size()) &&
+                                     cmd.firstVertex + static_cast<uint64_t>(cmd.vertexCount) <= vertices.size() &&
+                                     cmd.firstIndex + static_cast<uint64_t>(cmd.indexCount) <= indices.size();
+                if (!inRange) {
+                    error = "command out of range";
+                    return false;
+                }
+                for (uint32_t i = cmd.firstIndex; i < cmd.firstIndex + cmd.indexCount; i++) {
+                    if (indices[i] < 0 || static_cast<uint32_t>(indices[i]) >= cmd.vertexCount) {
+                        error = "index out of range";
+                        return false;
+                    }
+                }
+            }
+            logW = header.logW;
+            logH = header.logH;
+            frames = header.frames;
+            return true;
+        }
+};
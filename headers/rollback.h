@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// inputs of every player of a rollback session by tick. the local player's input is known right
+// away, a remote player's arrives some ticks later: until then ticks are simulated with a
+// prediction (the last input known from that player), and when the real one turns out different
+// every tick from there has to be simulated again
+class RollbackInputs {
+    public:
+        static const int HISTORY = 256; // ticks kept, far more than a rollback can reach back
+
+    private:
+        struct Player {
+            std::vector<uint8_t> known; // by tick % HISTORY
+            std::vector<uint8_t> used; // what each tick was last simulated with
+            int confirmed; // inputs of ticks before this are known
+            int simulated; // ticks before this have been simulated
+        };
+        std::vector<Player> players;
+
+    public:
+        void setup(int count) {
+            players.assign(count, Player { .known = std::vector<uint8_t>(HISTORY), .used = std::vector<uint8_t>(HISTORY),
+                                           .confirmed = 0, .simulated = 0 });
+        }
+        int getConfirmed(int player) const {
+            return players[player].confirmed;
+        }
+        // known input of an earlier tick, for sending it to the other side
+        uint8_t getKnown(int player, int tick) const {
+            return players[player].known[tick % HISTORY];
+        }
+        // the input to simulate tick with, a prediction if it isn't known yet
+        uint8_t take(int player, int tick) {
+            Player &p = players[player];
+            p.simulated = std::max(p.simulated, tick + 1);
+            if (tick < p.confirmed) {
+                return p.known[tick % HISTORY];
+            }
+            const uint8_t predicted = p.confirmed > 0 ? p.known[(p.confirmed - 1) % HISTORY] : 0;
+            p.used[tick % HISTORY] = predicted;
+            return predicted;
+        }
+        // the real input of tick. inputs have to come in tick order, anything but the next unknown
+        // tick is a duplicate or early and ignored. returns tick if it was already simulated with a
+        // different prediction, -1 otherwise
+        int confirm(int player, int tick, uint8_t input) {
+            Player &p = players[player];
+            if (tick != p.confirmed) {
+                return -1;
+            }
+            p.known[tick % HISTORY] = input;
+            p.confirmed++;
+            return tick < p.simulated && p.used[tick % HISTORY] != input ? tick : -1;
+        }
+};
+
+// what a peer sends every tick: its own inputs from the first tick the other side hasn't
+// acknowledged, so a lost packet is covered by the ones after it. sent as these bytes
+struct InputPacket {
+    static const int MAX_INPUTS = 64;
+
+    int32_t first; // tick of inputs[0]
+    int32_t ack; // the sender has the receiver's inputs of every tick before this
+    int32_t count;
+    uint8_t inputs[MAX_INPUTS];
+
+    void write(std::vector<uint8_t> &out) const {
+        out.resize(sizeof(InputPacket));
+        memcpy(out.data(), this, sizeof(InputPacket));
+    }
+    // false if bytes isn't an input packet
+    bool read(const std::vector<uint8_t> &bytes) {
+        if (bytes.size() != sizeof(InputPacket)) {
+            return false;
+        }
+        memcpy(this, bytes.data(), sizeof(InputPacket));
+        return first >= 0 && count >= 0 && count <= MAX_INPUTS;
+    }
+};
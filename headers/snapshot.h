@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <initializer_list>
+
+// appends plain values and arrays of them to a byte buffer. only trivially copyable types go
+// in, so everything is written with memcpy and the result has no pointers in it
+class SnapshotWriter {
+    std::vector<uint8_t> &out;
+
+    public:
+        SnapshotWriter(std::vector<uint8_t> &out) : out(out) {
+
+        }
+        void putBytes(const void *data, size_t size) {
+            const size_t at = out.size();
+            out.resize(at + size); // keeps the capacity of earlier snapshots, see WorldSnapshot
+            if (size > 0) {
+                memcpy(out.data() + at, data, size);
+            }
+        }
+        template<typename T>
+        void put(const T &value) {
+            static_assert(std::is_trivially_copyable_v<T>, "snapshots only hold plain data");
+            putBytes(&value, sizeof(T));
+        }
+        // element count, then the elements
+        template<typename T>
+        void putArray(const std::vector<T> &values) {
+            static_assert(std::is_trivially_copyable_v<T>, "snapshots only hold plain data");
+            put(static_cast<uint32_t>(values.size()));
+            putBytes(values.data(), values.size() * sizeof(T));
+        }
+};
+
+// reads back what a SnapshotWriter wrote, in the same order. running past the end sets failed
+// and makes every later read a no op, so callers can check once at the end
+class SnapshotReader {
+    const uint8_t *data;
+    size_t size, at;
+
+    public:
+        bool failed;
+
+        SnapshotReader(const std::vector<uint8_t> &in) : data(in.data()), size(in.size()), at(0), failed(false) {
+
+        }
+        bool getBytes(void *out, size_t bytes) {
+            if (failed || bytes > size - at) {
+                failed = true;
+                return false;
+            }
+            if (bytes > 0) {
+                memcpy(out, data + at, bytes);
+            }
+            at += bytes;
+            return true;
+        }
+        template<typename T>
+        bool get(T &value) {
+            static_assert(std::is_trivially_copyable_v<T>, "snapshots only hold plain data");
+            return getBytes(&value, sizeof(T));
+        }
+        // resizes values to the stored count, a vector that is big enough already doesn't allocate
+        template<typename T>
+        bool getArray(std::vector<T> &values) {
+            static_assert(std::is_trivially_copyable_v<T>, "snapshots only hold plain data");
+            uint32_t count = 0;
+            if (!get(count) || count > (size - at) / sizeof(T)) {
+                failed = true;
+                return false;
+            }
+            values.resize(count);
+            return getBytes(values.data(), count * sizeof(T));
+        }
+        bool atEnd() const {
+            return at == size;
+        }
+};
+
+// the whole simulation state at the end of one tick as a single flat buffer, see captureSnapshot
+// and restoreSnapshot. layout:
+//   Header, then the sections captureSnapshot writes, arrays as uint32 count + elements.
+// structs are copied as they are in memory, so a snapshot is only good for the build that made
+// it: the header keeps the format version and a fingerprint of the struct sizes to refuse others
+class WorldSnapshot {
+    public:
+        static const uint32_t VERSION = 1;
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t layout; // struct sizes of the build, see layoutOf
+            int32_t cols, rows; // of the level, a snapshot only fits the level it was taken in
+            uint64_t tick;
+        };
+
+        std::vector<uint8_t> bytes;
+
+        // cheap hash of the sizes of everything copied raw
+        static uint32_t layoutOf(std::initializer_list<size_t> sizes) {
+            uint32_t hash = 2166136261u;
+            for (size_t s : sizes) {
+                hash = (hash ^ static_cast<uint32_t>(s)) * 16777619u;
+            }
+            return hash;
+        }
+        size_t size() const {
+            return bytes.size();
+        }
+        bool empty() const {
+            return bytes.empty();
+        }
+        bool save(const char *path) const {
+            FILE *f = fopen(path, "wb");
+            if (!f) {
+                return false;
+            }
+            const bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+            return fclose(f) == 0 && ok;
+        }
+        // the bytes only, restoreSnapshot checks them
+        bool load(const char *path, std::string &error) {
+            FILE *f = fopen(path, "rb");
+            if (!f) {
+                error = "can't open file";
+                return false;
+            }
+            bytes.clear();
+            uint8_t buffer[4096];
+            for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0;) {
+                bytes.insert(bytes.end(), buffer, buffer + n);
+            }
+            fclose(f);
+            return true;
+        }
+};
+
+// the last capacity snapshots, oldest overwritten first. the buffers are reused, so once each
+// slot has held a snapshot of the current size taking another one doesn't allocate
+class SnapshotRing {
+    std::vector<WorldSnapshot> slots;
+    size_t newest, count;
+
+    public:
+        SnapshotRing() : newest(0), count(0) {
+
+        }
+        void setCapacity(size_t capacity) {
+            slots.assign(capacity, WorldSnapshot());
+            newest = 0;
+            count = 0;
+        }
+        size_t size() const {
+            return count;
+        }
+        void clear() {
+            count = 0;
+        }
+        // slot to capture the next snapshot into, it replaces the oldest one when the ring is full
+        WorldSnapshot &push() {
+            newest = (newest + 1) % slots.size();
+            count = std::min(count + 1, slots.size());
+            return slots[newest];
+        }
+        // only valid while size() > 0
+        const WorldSnapshot &getNewest() const {
+            return slots[newest];
+        }
+        // drops the newest snapshot, the one before it becomes the newest
+        void pop() {
+            if (count > 0) {
+                newest = (newest + slots.size() - 1) % slots.size();
+                count--;
+            }
+        }
+        // total bytes held, for reporting
+        size_t bytes() const {
+            size_t total = 0;
+            for (const WorldSnapshot &snap : slots) {
+                total += snap.bytes.capacity();
+            }
+            return total;
+        }
+};
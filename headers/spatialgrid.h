@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <SDL3/SDL.h>
+
+// duplicate filter for SpatialGrid queries, one per thread that queries at the same time
+struct GridQuery {
+    std::vector<uint32_t> stamps; // last query that returned each id, used to skip duplicates
+    uint32_t stamp;
+    GridQuery() : stamp(0) {
+
+    }
+};
+
+// uniform grid broadphase. items are plain int ids, the owner keeps the id -> object mapping.
+// storage is rebuilt in bulk (insert everything, then build) into a flat cell -> ids table
+class SpatialGrid {
+    struct Pending {
+        int id;
+        int c0, r0, c1, r1;
+        SDL_FRect rect;
+    };
+    float cellSize;
+    float originX, originY;
+    int cols, rows;
+    std::vector<Pending> pending;
+    std::vector<int> cellStart; // cellStart[i]..cellStart[i + 1] are the ids in cell i
+    std::vector<int> entries;
+    std::vector<int> cursor;
+    std::vector<SDL_FRect> bounds; // rect of each id as inserted, for the exact queries
+    int idCount; // highest id inserted + 1
+    GridQuery ownQuery; // for the single threaded query
+
+    int cellX(float x) const {
+        return std::clamp(static_cast<int>((x - originX) / cellSize), 0, cols - 1);
+    }
+    int cellY(float y) const {
+        return std::clamp(static_cast<int>((y - originY) / cellSize), 0, rows - 1);
+    }
+
+    public:
+        SpatialGrid() : cellSize(1), originX(0), originY(0), cols(1), rows(1), idCount(0) {
+
+        }
+        // positions outside the grid are clamped onto the border cells
+        void resize(int cols, int rows, float cellSize, float originX = 0, float originY = 0) {
+            this->cols = std::max(cols, 1);
+            this->rows = std::max(rows, 1);
+            this->cellSize = cellSize;
+            this->originX = originX;
+            this->originY = originY;
+            cellStart.assign(this->cols * this->rows + 1, 0);
+        }
+        void clear() {
+            pending.clear();
+            entries.clear();
+        }
+        void insert(int id, const SDL_FRect &rect) {
+            pending.push_back(Pending {
+                .id = id,
+                .c0 = cellX(rect.x),
+                .r0 = cellY(rect.y),
+                .c1 = cellX(rect.x + rect.w),
+                .r1 = cellY(rect.y + rect.h),
+                .rect = rect
+            });
+        }
+        void build() {
+            // count, prefix sum, then scatter ids into their cells
+            std::fill(cellStart.begin(), cellStart.end(), 0);
+            int maxId = -1;
+            for (const Pending &p : pending) {
+                for (int r = p.r0; r <= p.r1; r++) {
+                    for (int c = p.c0; c <= p.c1; c++) {
+                        cellStart[r * cols + c + 1]++;
+                    }
+                }
+                maxId = std::max(maxId, p.id);
+            }
+            for (size_t i = 1; i < cellStart.size(); i++) {
+                cellStart[i] += cellStart[i - 1];
+            }
+            entries.resize(cellStart.back());
+            cursor.assign(cellStart.begin(), cellStart.end() - 1);
+            for (const Pending &p : pending) {
+                for (int r = p.r0; r <= p.r1; r++) {
+                    for (int c = p.c0; c <= p.c1; c++) {
+                        entries[cursor[r * cols + c]++] = p.id;
+                    }
+                }
+            }
+            idCount = maxId + 1;
+            bounds.resize(idCount);
+            for (const Pending &p : pending) {
+                bounds[p.id] = p.rect;
+            }
+        }
+        // fills out with each id whose cells overlap rect exactly once, in ascending id order
+        void query(const SDL_FRect &rect, std::vector<int> &out) {
+            query(rect, out, ownQuery);
+        }
+        // same, with the caller's duplicate filter so several threads can query at once
+        void query(const SDL_FRect &rect, std::vector<int> &out, GridQuery &q) const {
+            out.clear();
+            if (static_cast<int>(q.stamps.size()) < idCount) {
+                q.stamps.resize(idCount, 0);
+            }
+            if (++q.stamp == 0) { // wrapped, old stamps are no longer trustworthy
+                std::fill(q.stamps.begin(), q.stamps.end(), 0);
+                q.stamp = 1;
+            }
+            const int c0 = cellX(rect.x), c1 = cellX(rect.x + rect.w);
+            const int r0 = cellY(rect.y), r1 = cellY(rect.y + rect.h);
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    const int cell = r * cols + c;
+                    for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                        const int id = entries[i];
+                        if (q.stamps[id] != q.stamp) {
+                            q.stamps[id] = q.stamp;
+                            out.push_back(id);
+                        }
+                    }
+                }
+            }
+            std::sort(out.begin(), out.end()); // keep the same response order as a linear scan
+        }
+        // ids whose rect overlaps rect, tested exactly rather than by cell. ascending
+        void queryRect(const SDL_FRect &rect, std::vector<int> &out, GridQuery &q) const {
+            query(rect, out, q);
+            std::erase_if(out, [&](int id) {
+                const SDL_FRect &b = bounds[id];
+                return b.x > rect.x + rect.w || b.x + b.w < rect.x || b.y > rect.y + rect.h || b.y + b.h < rect.y;
+            });
+        }
+        // ids whose rect comes within radius of x, y. ascending
+        void queryRadius(float x, float y, float radius, std::vector<int> &out, GridQuery &q) const {
+            query(SDL_FRect { .x = x - radius, .y = y - radius, .w = radius * 2, .h = radius * 2 }, out, q);
+            std::erase_if(out, [&](int id) {
+                const SDL_FRect &b = bounds[id];
+                const float dx = x - std::clamp(x, b.x, b.x + b.w); // to the closest point of the rect
+                const float dy = y - std::clamp(y, b.y, b.y + b.h);
+                return dx * dx + dy * dy > radius * radius;
+            });
+        }
+};
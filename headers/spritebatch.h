@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <SDL3/SDL.h>
+#include "../headers/rendercapture.h"
+
+// collects the textured quads of a frame and submits them with SDL_RenderGeometry, one call per
+// run of quads sharing a layer and texture. lower layers are drawn first, inside a layer quads
+// are grouped by texture and otherwise keep the order they were added in
+class SpriteBatch {
+    struct Quad {
+        int layer;
+        uint32_t order;
+        SDL_Texture *texture;
+        SDL_FRect src, dst;
+        bool fullTexture; // no src rect, sample the whole texture
+        SDL_FlipMode flip;
+        SDL_FColor color;
+    };
+    std::vector<Quad> quads;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    int drawCalls, quadCount; // stats of the last flush
+
+    public:
+        SpriteBatch() : drawCalls(0), quadCount(0) {
+
+        }
+        // src in pixels like SDL_RenderTexture, nullptr for the whole texture.
+        // color multiplies the texture, above 1 brightens it (hit flash)
+        void draw(int layer, SDL_Texture *texture, const SDL_FRect *src, const SDL_FRect &dst,
+                  SDL_FlipMode flip = SDL_FLIP_NONE, SDL_FColor color = SDL_FColor { 1, 1, 1, 1 }) {
+            if (!texture) {
+                return;
+            }
+            quads.push_back(Quad {
+                .layer = layer,
+                .order = static_cast<uint32_t>(quads.size()),
+                .texture = texture,
+                .src = src ? *src : SDL_FRect { 0 },
+                .dst = dst,
+                .fullTexture = !src,
+                .flip = flip,
+                .color = color
+            });
+        }
+        // sort, build the vertices and draw everything queued since the last flush, the draws go
+        // into capture too when there is one
+        void flush(SDL_Renderer *renderer, RenderCapture *capture = nullptr) {
+            std::sort(quads.begin(), quads.end(), [](const Quad &a, const Quad &b) {
+                if (a.layer != b.layer) {
+                    return a.layer < b.layer;
+                }
+                if (a.texture != b.texture) {
+                    return std::less<SDL_Texture *>()(a.texture, b.texture);
+                }
+                return a.order < b.order;
+            });
+            drawCalls = 0;
+            quadCount = static_cast<int>(quads.size());
+            size_t start = 0;
+            while (start < quads.size()) {
+                const Quad &first = quads[start];
+                float texW = 1, texH = 1;
+                SDL_GetTextureSize(first.texture, &texW, &texH);
+                vertices.clear();
+                indices.clear();
+                size_t end = start;
+                for (; end < quads.size() && quads[end].layer == first.layer && quads[end].texture == first.texture; end++) {
+                    const Quad &q = quads[end];
+                    float u0 = 0, v0 = 0, u1 = 1, v1 = 1;
+                    if (!q.fullTexture) {
+                        u0 = q.src.x / texW;
+                        v0 = q.src.y / texH;
+                        u1 = (q.src.x + q.src.w) / texW;
+                        v1 = (q.src.y + q.src.h) / texH;
+                    }
+                    if (q.flip & SDL_FLIP_HORIZONTAL) {
+                        std::swap(u0, u1);
+                    }
+                    if (q.flip & SDL_FLIP_VERTICAL) {
+                        std::swap(v0, v1);
+                    }
+                    const int base = static_cast<int>(vertices.size());
+                    const float x0 = q.dst.x, y0 = q.dst.y, x1 = q.dst.x + q.dst.w, y1 = q.dst.y + q.dst.h;
+                    vertices.push_back(SDL_Vertex { { x0, y0 }, q.color, { u0, v0 } });
+                    vertices.push_back(SDL_Vertex { { x1, y0 }, q.color, { u1, v0 } });
+                    vertices.push_back(SDL_Vertex { { x1, y1 }, q.color, { u1, v1 } });
+                    vertices.push_back(SDL_Vertex { { x0, y1 }, q.color, { u0, v1 } });
+                    const int quadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+                    for (int i : quadIndices) {
+                        indices.push_back(base + i);
+                    }
+                }
+                SDL_RenderGeometry(renderer, first.texture, vertices.data(), static_cast<int>(vertices.size()),
+                                   indices.data(), static_cast<int>(indices.size()));
+                if (capture) {
+                    capture->geometry(renderer, first.texture, vertices.data(), static_cast<int>(vertices.size()),
+                                      indices.data(), static_cast<int>(indices.size()));
+                }
+                drawCalls++;
+                start = end;
+            }
+            quads.clear();
+        }
+        int getDrawCalls() const {
+            return drawCalls;
+        }
+        int getQuadCount() const {
+            return quadCount;
+        }
+};
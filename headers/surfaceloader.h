@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+// one image file to decode, surface and decodeNS are filled in by decodeSurfaces
+struct DecodeJob {
+    std::string path;
+    SDL_Surface *surface;
+    uint64_t decodeNS;
+    std::string error; // why surface is null, SDL errors are per thread so the worker keeps it here
+    DecodeJob(const std::string &path) : path(path), surface(nullptr), decodeNS(0) {
+
+    }
+};
+
+// decodes every job with IMG_Load on up to threadCount worker threads. surfaces don't touch the
+// renderer so this is safe off the main thread, turning them into textures is left to the caller
+inline void decodeSurfaces(std::vector<DecodeJob> &jobs, int threadCount) {
+    if (jobs.empty()) {
+        return;
+    }
+    std::atomic<size_t> next = 0;
+    const auto work = [&jobs, &next]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const uint64_t start = SDL_GetTicksNS();
+            jobs[i].surface = IMG_Load(jobs[i].path.c_str());
+            if (!jobs[i].surface) {
+                jobs[i].error = SDL_GetError();
+            }
+            jobs[i].decodeNS = SDL_GetTicksNS() - start;
+        }
+    };
+    threadCount = std::clamp(threadCount, 1, static_cast<int>(jobs.size()));
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threadCount; t++) {
+        workers.emplace_back(work);
+    }
+    work(); // the calling thread helps too
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <SDL3/SDL.h>
+#include "../ext/glm/glm.hpp"
+
+// where a moving box first touches another one
+struct SweepHit {
+    float time; // fraction of the move done before touching, 0..1
+    glm::vec2 normal; // of the face that was hit, pointing back at the mover
+};
+
+// world rectangle of a collider at pos
+inline SDL_FRect colliderRect(glm::vec2 pos, const SDL_FRect &collider) {
+    return SDL_FRect {
+        .x = pos.x + collider.x,
+        .y = pos.y + collider.y,
+        .w = collider.w,
+        .h = collider.h
+    };
+}
+
+// true if a and b share some area, boxes that only touch don't overlap
+inline bool rectsOverlap(const SDL_FRect &a, const SDL_FRect &b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// swept AABB: moving travels by move, does it run into target on the way and when. each axis
+// gives the time span its projections overlap, the boxes touch where the spans of both axes
+// do, and the axis that started overlapping last is the face that was hit. boxes overlapping
+// before the move are no hit, see pushOutNormal
+inline bool sweepRect(const SDL_FRect &moving, glm::vec2 move, const SDL_FRect &target, SweepHit &hit) {
+    const float inf = std::numeric_limits<float>::infinity();
+    const auto axisSpan = [inf](float pos, float size, float targetPos, float targetSize, float d, float &entry, float &exit) {
+        if (d > 0) {
+            entry = (targetPos - (pos + size)) / d;
+            exit = (targetPos + targetSize - pos) / d;
+        } else if (d < 0) {
+            entry = (targetPos + targetSize - pos) / d;
+            exit = (targetPos - (pos + size)) / d;
+        } else if (pos + size > targetPos && pos < targetPos + targetSize) { // not moving on this axis
+            entry = -inf;
+            exit = inf;
+        } else {
+            return false;
+        }
+        return true;
+    };
+    float entryX, exitX, entryY, exitY;
+    if (!axisSpan(moving.x, moving.w, target.x, target.w, move.x, entryX, exitX) ||
+        !axisSpan(moving.y, moving.h, target.y, target.h, move.y, entryY, exitY)) {
+        return false;
+    }
+    const float entry = std::max(entryX, entryY);
+    const float exit = std::min(exitX, exitY);
+    if (entry >= exit || entry < 0 || entry >= 1) {
+        return false;
+    }
+    hit.time = entry;
+    hit.normal = entryX > entryY ? glm::vec2(move.x > 0 ? -1 : 1, 0) : glm::vec2(0, move.y > 0 ? -1 : 1);
+    return true;
+}
+
+// for boxes that overlap without having moved into each other: the face of b a is closest to
+// leaving through, pointing towards a
+inline glm::vec2 pushOutNormal(const SDL_FRect &a, const SDL_FRect &b) {
+    const float overlapX = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    const float overlapY = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    if (overlapX < overlapY) {
+        return glm::vec2(a.x + a.w / 2 < b.x + b.w / 2 ? -1 : 1, 0);
+    }
+    return glm::vec2(0, a.y + a.h / 2 < b.y + b.h / 2 ? -1 : 1);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <SDL3/SDL.h>
+#include "../headers/tilemap.h"
+#include "../headers/atlas.h"
+#include "../headers/spritebatch.h"
+
+// static tile layers pre-rendered into render target textures chunkCols columns wide, so drawing
+// them costs one quad per visible chunk instead of one per tile. chunks are baked the first time
+// they come into view and released again once they are far behind, so memory follows the camera
+// and not the level width. the textures belong to the renderer, release() them before it is destroyed
+class TileChunks {
+    SDL_Renderer *renderer;
+    std::vector<const TileMap *> maps; // drawn in order into the same chunks
+    const Sprite *tileSprites;
+    int chunkCols;
+    std::vector<SDL_Texture *> chunks; // nullptr until baked
+    std::vector<uint8_t> empty; // chunk has no tiles, it never gets a texture
+    std::vector<int> resident; // indices of the baked chunks
+    float chunkWidth, chunkHeight;
+    float originX, originY;
+
+    void bakeChunk(int k) {
+        const TileMap &first = *maps.front();
+        const int c0 = k * chunkCols;
+        const int c1 = std::min(c0 + chunkCols, first.getCols());
+        bool anyTiles = false;
+        for (const TileMap *map : maps) {
+            for (int c = c0; c < c1 && !anyTiles; c++) {
+                for (int r = 0; r < map->getRows() && !anyTiles; r++) {
+                    anyTiles = map->get(r, c);
+                }
+            }
+        }
+        if (!anyTiles) {
+            empty[k] = true;
+            return;
+        }
+        SDL_Texture *tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                             static_cast<int>(chunkWidth), static_cast<int>(chunkHeight));
+        SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST); // pixel perfect
+        SDL_Texture *prevTarget = SDL_GetRenderTarget(renderer);
+        SDL_SetRenderTarget(renderer, tex);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        for (const TileMap *map : maps) {
+            for (int r = 0; r < map->getRows(); r++) {
+                for (int c = c0; c < c1; c++) {
+                    const Sprite &sprite = tileSprites[map->get(r, c)];
+                    if (sprite.texture) { // empty cell or an id without a sprite
+                        SDL_FRect dst = map->cellRect(r, c);
+                        dst.x -= originX + k * chunkWidth; // chunk local
+                        dst.y -= originY;
+                        SDL_RenderTexture(renderer, sprite.texture, &sprite.rect, &dst);
+                    }
+                }
+            }
+        }
+        SDL_SetRenderTarget(renderer, prevTarget);
+        chunks[k] = tex;
+        resident.push_back(k);
+    }
+
+    public:
+        static const int KEEP_CHUNKS = 2; // baked chunks kept on each side of the visible ones
+
+        TileChunks() : renderer(nullptr), tileSprites(nullptr), chunkCols(1), chunkWidth(1), chunkHeight(0), originX(0), originY(0) {
+
+        }
+        // textures go, the setup stays so they are baked again on demand
+        void release() {
+            for (int k : resident) {
+                SDL_DestroyTexture(chunks[k]);
+                chunks[k] = nullptr;
+            }
+            resident.clear();
+        }
+        // maps must share size and origin and stay alive while the chunks are in use
+        void setup(SDL_Renderer *renderer, std::initializer_list<const TileMap *> maps, const Sprite *tileSprites, int chunkCols) {
+            release();
+            this->renderer = renderer;
+            this->maps.assign(maps.begin(), maps.end());
+            this->tileSprites = tileSprites;
+            this->chunkCols = chunkCols;
+            const TileMap &first = *this->maps.front();
+            const SDL_FRect corner = first.cellRect(0, 0);
+            originX = corner.x;
+            originY = corner.y;
+            chunkWidth = chunkCols * first.getTileSize();
+            chunkHeight = first.getRows() * first.getTileSize();
+            chunks.assign((first.getCols() + chunkCols - 1) / chunkCols, nullptr);
+            empty.assign(chunks.size(), false);
+        }
+        // queue the chunks overlapping viewport, at most two when chunks are wider than the screen
+        void draw(SpriteBatch &batch, int layer, const SDL_FRect &viewport) {
+            const int k0 = std::max(static_cast<int>(SDL_floorf((viewport.x - originX) / chunkWidth)), 0);
+            const int k1 = std::min(static_cast<int>(SDL_floorf((viewport.x + viewport.w - originX) / chunkWidth)),
+                                    static_cast<int>(chunks.size()) - 1);
+            // drop chunks the camera has moved well away from
+            for (size_t i = 0; i < resident.size();) {
+                const int k = resident[i];
+                if (k < k0 - KEEP_CHUNKS || k > k1 + KEEP_CHUNKS) {
+                    SDL_DestroyTexture(chunks[k]);
+                    chunks[k] = nullptr;
+                    resident[i] = resident.back();
+                    resident.pop_back();
+                } else {
+                    i++;
+                }
+            }
+            for (int k = k0; k <= k1; k++) {
+                if (!chunks[k] && !empty[k]) {
+                    bakeChunk(k);
+                }
+                if (empty[k]) {
+                    continue;
+                }
+                SDL_FRect dst {
+                    .x = originX + k * chunkWidth - viewport.x,
+                    .y = originY,
+                    .w = chunkWidth,
+                    .h = chunkHeight
+                };
+                batch.draw(layer, chunks[k], nullptr, dst);
+            }
+        }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <SDL3/SDL.h>
+
+// static level geometry as a dense grid of tile ids, one byte per cell. id 0 is empty.
+// cells are stored column by column, either in the map's own buffer or in memory it views
+class TileMap {
+    int rows, cols;
+    float tileSize;
+    float originX, originY; // world position of the top left corner of cell (0, 0)
+    std::vector<uint8_t> tiles;
+    uint8_t *external; // cells owned by someone else (a mapped level file), nullptr when using tiles
+
+    uint8_t *cells() {
+        return external ? external : tiles.data();
+    }
+    const uint8_t *cells() const {
+        return external ? external : tiles.data();
+    }
+
+    public:
+        TileMap() : rows(0), cols(0), tileSize(1), originX(0), originY(0), external(nullptr) {
+
+        }
+        void resize(int rows, int cols, float tileSize, float originX = 0, float originY = 0) {
+            this->rows = rows;
+            this->cols = cols;
+            this->tileSize = tileSize;
+            this->originX = originX;
+            this->originY = originY;
+            tiles.assign(static_cast<size_t>(rows) * cols, 0);
+            external = nullptr;
+        }
+        // use rows * cols column major cells that stay owned by the caller and must outlive the map
+        void view(int rows, int cols, float tileSize, float originX, float originY, uint8_t *cells) {
+            this->rows = rows;
+            this->cols = cols;
+            this->tileSize = tileSize;
+            this->originX = originX;
+            this->originY = originY;
+            tiles.clear();
+            tiles.shrink_to_fit();
+            external = cells;
+        }
+        int getRows() const {
+            return rows;
+        }
+        int getCols() const {
+            return cols;
+        }
+        float getTileSize() const {
+            return tileSize;
+        }
+        uint8_t get(int r, int c) const { // anything outside the map is empty
+            if (r < 0 || r >= rows || c < 0 || c >= cols) {
+                return 0;
+            }
+            return cells()[static_cast<size_t>(c) * rows + r];
+        }
+        void set(int r, int c, uint8_t id) {
+            cells()[static_cast<size_t>(c) * rows + r] = id;
+        }
+        int colAt(float x) const {
+            return static_cast<int>(SDL_floorf((x - originX) / tileSize));
+        }
+        int rowAt(float y) const {
+            return static_cast<int>(SDL_floorf((y - originY) / tileSize));
+        }
+        SDL_FRect cellRect(int r, int c) const {
+            return SDL_FRect {
+                .x = originX + c * tileSize,
+                .y = originY + r * tileSize,
+                .w = tileSize,
+                .h = tileSize
+            };
+        }
+        // calls fn(r, c, id) for every non empty cell touching rect grown by pad cells, row by row
+        template <typename F>
+        void forEachTile(const SDL_FRect &rect, int pad, F &&fn) const {
+            const int r0 = std::max(rowAt(rect.y) - pad, 0);
+            const int r1 = std::min(rowAt(rect.y + rect.h) + pad, rows - 1);
+            const int c0 = std::max(colAt(rect.x) - pad, 0);
+            const int c1 = std::min(colAt(rect.x + rect.w) + pad, cols - 1);
+            const uint8_t *data = cells();
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    const uint8_t id = data[static_cast<size_t>(c) * rows + r];
+                    if (id) {
+                        fn(r, c, id);
+                    }
+                }
+            }
+        }
+        // true if rect overlaps any non empty cell
+        bool overlapsSolid(const SDL_FRect &rect) const {
+            bool found = false;
+            forEachTile(rect, 0, [&](int r, int c, uint8_t) {
+                SDL_FRect cell = cellRect(r, c);
+                found = found || SDL_HasRectIntersectionFloat(&rect, &cell);
+            });
+            return found;
+        }
+};
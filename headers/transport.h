@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+
+// unreliable datagrams between two peers, like UDP: a packet arrives whole or not at all
+class Transport {
+    public:
+        virtual ~Transport() {
+
+        }
+        virtual void send(const std::vector<uint8_t> &packet) = 0;
+        // the oldest packet that has arrived into packet, false if none has
+        virtual bool receive(std::vector<uint8_t> &packet) = 0;
+};
+
+// both ends of a connection inside one process, with a fixed one way latency and a share of
+// packets lost on the way, to test rollback without a network. time only moves with setTime,
+// so runs on simulated time come out the same every time
+class LoopbackLink {
+    struct InFlight {
+        uint64_t arrival; // ns
+        std::vector<uint8_t> bytes;
+    };
+
+    class End : public Transport {
+        LoopbackLink &link;
+        int side;
+
+        public:
+            End(LoopbackLink &link, int side) : link(link), side(side) {
+
+            }
+            void send(const std::vector<uint8_t> &packet) override {
+                link.sent++;
+                if (link.random() < link.loss) {
+                    link.lost++;
+                    return;
+                }
+                link.queues[side ^ 1].push_back(InFlight { .arrival = link.now + link.latencyNS, .bytes = packet });
+            }
+            bool receive(std::vector<uint8_t> &packet) override {
+                std::deque<InFlight> &queue = link.queues[side];
+                if (queue.empty() || queue.front().arrival > link.now) { // same latency both ways, so it stays in order
+                    return false;
+                }
+                packet.swap(queue.front().bytes);
+                queue.pop_front();
+                return true;
+            }
+    };
+
+    std::deque<InFlight> queues[2]; // by receiving side
+    End ends[2];
+    uint64_t now, latencyNS;
+    float loss; // 0..1
+    uint32_t rng;
+    int sent, lost;
+
+    float random() { // xorshift, 0..1
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return (rng >> 8) * (1.0f / 16777216.0f);
+    }
+
+    public:
+        LoopbackLink(uint64_t latencyNS, float loss, uint32_t seed = 0x9e3779b9u) :
+            ends{ End(*this, 0), End(*this, 1) }, now(0), latencyNS(latencyNS), loss(loss), rng(seed ? seed : 1), sent(0), lost(0) {
+
+        }
+        LoopbackLink(const LoopbackLink &) = delete; // the ends point back at the link
+        Transport &getEnd(int side) {
+            return ends[side];
+        }
+        void setTime(uint64_t ns) {
+            now = ns;
+        }
+        int getSent() const {
+            return sent;
+        }
+        int getLost() const {
+            return lost;
+        }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <SDL3/SDL.h>
+#include "../ext/glm/glm.hpp"
+#include "../headers/snapshot.h"
+
+// an enemy taken out of the simulation while its chunk is suspended. only the state that
+// changes during play is kept, the rest comes back from the spawn template
+struct ParkedEnemy {
+    glm::vec2 pos, vel;
+    int8_t dir;
+    uint8_t state; // EnemyState
+    int16_t healthPoints;
+};
+
+// splits the level into chunks of chunkCols columns and keeps only the ones around the camera
+// active. characters in the other chunks are parked as compact records, so the simulation and
+// the broadphase cost follow the camera instead of the level width
+class WorldStream {
+    float originX, chunkWidth;
+    int chunkCols, chunkCount;
+    int first, last; // active chunks, empty (first > last) until the first retarget
+    std::vector<std::vector<ParkedEnemy>> parked; // per chunk
+    size_t parkedCount;
+
+    public:
+        static const int MARGIN_CHUNKS = 1; // active chunks on each side of the visible ones, loaded before they show
+
+        WorldStream() : originX(0), chunkWidth(1), chunkCols(1), chunkCount(0), first(0), last(-1), parkedCount(0) {
+
+        }
+        // forgets everything parked, nothing is active until the next retarget
+        void setup(int cols, int chunkCols, float tileSize, float originX = 0) {
+            this->chunkCols = std::max(chunkCols, 1);
+            this->originX = originX;
+            chunkWidth = this->chunkCols * tileSize;
+            chunkCount = std::max((cols + this->chunkCols - 1) / this->chunkCols, 1);
+            parked.clear();
+            parked.resize(chunkCount);
+            parkedCount = 0;
+            first = 0;
+            last = -1;
+        }
+        int chunkAt(float x) const {
+            return std::clamp(static_cast<int>(SDL_floorf((x - originX) / chunkWidth)), 0, chunkCount - 1);
+        }
+        int getChunkCols() const {
+            return chunkCols;
+        }
+        int getFirst() const {
+            return first;
+        }
+        int getLast() const {
+            return last;
+        }
+        // world x range of the active chunks, the outer chunks reach to infinity so nothing is lost off the ends
+        bool isActive(float x) const {
+            const int k = chunkAt(x);
+            return k >= first && k <= last;
+        }
+        float activeLeft() const {
+            return originX + first * chunkWidth;
+        }
+        size_t getParkedCount() const {
+            return parkedCount;
+        }
+        void park(const ParkedEnemy &e) {
+            parked[chunkAt(e.pos.x)].push_back(e);
+            parkedCount++;
+        }
+        // what was parked in chunk k goes into out. the chunk keeps its storage, so parking there
+        // again or copying a stream over this one (restartLevel) doesn't allocate
+        void unpark(int k, std::vector<ParkedEnemy> &out) {
+            out.assign(parked[k].begin(), parked[k].end());
+            parked[k].clear();
+            parkedCount -= out.size();
+        }
+        // the active range and every parked enemy, chunk by chunk. the chunk layout isn't stored,
+        // it comes from the level
+        void save(SnapshotWriter &out) const {
+            out.put(first);
+            out.put(last);
+            out.put(static_cast<uint32_t>(parked.size()));
+            for (const std::vector<ParkedEnemy> &chunk : parked) {
+                out.putArray(chunk);
+            }
+        }
+        // false if the snapshot is damaged or was taken with a different chunk layout
+        bool load(SnapshotReader &in) {
+            uint32_t chunks = 0;
+            in.get(first);
+            in.get(last);
+            if (!in.get(chunks) || chunks != parked.size()) {
+                return false;
+            }
+            parkedCount = 0;
+            for (std::vector<ParkedEnemy> &chunk : parked) {
+                in.getArray(chunk);
+                parkedCount += chunk.size();
+            }
+            return !in.failed && first >= 0 && last < chunkCount;
+        }
+        // moves the active range over viewport. false if it didn't change, otherwise entered and
+        // left are filled with the chunks that just became active and inactive
+        bool retarget(const SDL_FRect &viewport, std::vector<int> &entered, std::vector<int> &left) {
+            entered.clear();
+            left.clear();
+            const int newFirst = std::max(chunkAt(viewport.x) - MARGIN_CHUNKS, 0);
+            const int newLast = std::min(chunkAt(viewport.x + viewport.w) + MARGIN_CHUNKS, chunkCount - 1);
+            if (newFirst == first && newLast == last) {
+                return false;
+            }
+            for (int k = first; k <= last; k++) {
+                if (k < newFirst || k > newLast) {
+                    left.push_back(k);
+                }
+            }
+            for (int k = newFirst; k <= newLast; k++) {
+                if (k < first || k > last) {
+                    entered.push_back(k);
+                }
+            }
+            first = newFirst;
+            last = newLast;
+            return true;
+        }
+};
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "headers/rendercapture.h"
+
+// plays a render capture from the game (--capture or F8) back against a renderer backend and
+// reports how fast the backend gets through it. nothing is shown: the software renderer draws
+// into a plain surface, any other draws into a target texture of a hidden window
+//   renderreplay frames.rcap [--renderer name] [--repeat n] [--unbatched]
+//   renderreplay --list
+// name is a render driver SDL knows (software, opengl, direct3d11, vulkan...), without one SDL
+// picks like the game does. --unbatched draws every sprite quad on its own with
+// SDL_RenderTextureRotated and a texture color mod instead of one geometry call per run, to see
+// what batching is worth on a backend
+
+const int DEFAULT_REPEAT = 10; // passes over the capture that are timed, after one that isn't
+
+struct ReplayStats {
+    uint64_t commands; // as recorded
+    uint64_t drawCalls; // as issued, more than commands with --unbatched
+    uint64_t quads;
+    uint64_t textureChanges, blendChanges, colorChanges; // renderer state that differs from the draw before
+    uint64_t frames;
+};
+
+struct ReplayTarget {
+    SDL_Window *window;
+    SDL_Surface *surface; // software
+    SDL_Renderer *renderer;
+    SDL_Texture *target; // everything else
+};
+
+bool createTarget(ReplayTarget &out, const char *name, int w, int h);
+void destroyTarget(ReplayTarget &out);
+std::vector<SDL_Texture *> createTextures(SDL_Renderer *renderer, const RenderCapture &capture);
+void replay(SDL_Renderer *renderer, const RenderCapture &capture, const std::vector<SDL_Texture *> &textures,
+            std::vector<SDL_FColor> &colorMods, bool unbatched, ReplayStats &stats);
+bool isQuads(const RenderCapture &capture, const RenderCapture::Command &cmd);
+void drawQuads(SDL_Renderer *renderer, const RenderCapture &capture, const RenderCapture::Command &cmd,
+               SDL_Texture *texture, SDL_FColor &colorMod, ReplayStats &stats);
+void finishDrawing(SDL_Renderer *renderer);
+
+int main(int argc, char** argv) {
+    const char *path = nullptr;
+    const char *rendererName = nullptr;
+    int repeat = DEFAULT_REPEAT;
+    bool unbatched = false;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--renderer") && i + 1 < argc) {
+            rendererName = argv[++i];
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "--unbatched")) {
+            unbatched = true;
+        } else if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (list) {
+        for (int i = 0; i < SDL_GetNumRenderDrivers(); i++) {
+            printf("%s\n", SDL_GetRenderDriver(i));
+        }
+        return 0;
+    }
+    if (!path) {
+        printf("usage: renderreplay capture.rcap [--renderer name] [--repeat n] [--unbatched]\n"
+               "       renderreplay --list\n");
+        return 1;
+    }
+    RenderCapture capture;
+    std::string error;
+    if (!capture.load(path, error)) {
+        printf("can't load %s: %s\n", path, error.c_str());
+        return 1;
+    }
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        printf("can't initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+    ReplayTarget target;
+    if (!createTarget(target, rendererName, capture.logW, capture.logH)) {
+        printf("can't create renderer %s: %s\n", rendererName ? rendererName : "(default)", SDL_GetError());
+        destroyTarget(target);
+        SDL_Quit();
+        return 1;
+    }
+    const std::vector<SDL_Texture *> textures = createTextures(target.renderer, capture);
+    std::vector<SDL_FColor> colorMods(textures.size(), SDL_FColor { 1, 1, 1, 1 }); // of each texture, --unbatched sets them
+
+    // the first pass uploads the textures and warms up the backend, only the ones after it count
+    ReplayStats warmup { 0 };
+    replay(target.renderer, capture, textures, colorMods, unbatched, warmup);
+    finishDrawing(target.renderer);
+    ReplayStats stats { 0 };
+    const uint64_t start = SDL_GetTicksNS();
+    for (int pass = 0; pass < repeat; pass++) {
+        replay(target.renderer, capture, textures, colorMods, unbatched, stats);
+    }
+    finishDrawing(target.renderer);
+    const double seconds = std::max(SDL_GetTicksNS() - start, static_cast<uint64_t>(1)) / static_cast<double>(SDL_NS_PER_SECOND);
+
+    const double frames = static_cast<double>(std::max(stats.frames, static_cast<uint64_t>(1)));
+    printf("%s: %u frames of %dx%d, %zu textures, replayed %d times on %s%s\n", path, capture.frames, capture.logW,
+           capture.logH, capture.textures.size(), repeat, SDL_GetRendererName(target.renderer), unbatched ? ", unbatched" : "");
+    printf("  %.2f ms, %.2f ms per frame, %.0f frames/s\n", seconds * 1e3, seconds * 1e3 / frames, frames / seconds);
+    printf("  %.0f commands/s, %.0f draw calls/s, %.0f quads/s\n", stats.commands / seconds, stats.drawCalls / seconds,
+           stats.quads / seconds);
+    printf("  per frame: %.1f commands, %.1f draw calls, %.1f quads\n", stats.commands / frames, stats.drawCalls / frames,
+           stats.quads / frames);
+    printf("  state changes per frame: texture %.1f, blend %.1f, color %.1f\n", stats.textureChanges / frames,
+           stats.blendChanges / frames, stats.colorChanges / frames);
+
+    for (SDL_Texture *tex : textures) {
+        SDL_DestroyTexture(tex);
+    }
+    destroyTarget(target);
+    SDL_Quit();
+    return 0;
+}
+
+bool createTarget(ReplayTarget &out, const char *name, int w, int h) {
+    out = ReplayTarget { .window = nullptr, .surface = nullptr, .renderer = nullptr, .target = nullptr };
+    if (name && !strcmp(name, "software")) { // no window needed
+        out.surface = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGBA8888);
+        out.renderer = out.surface ? SDL_CreateSoftwareRenderer(out.surface) : nullptr;
+        return out.renderer;
+    }
+    out.window = SDL_CreateWindow("renderreplay", w, h, SDL_WINDOW_HIDDEN);
+    out.renderer = out.window ? SDL_CreateRenderer(out.window, name) : nullptr;
+    if (!out.renderer) {
+        return false;
+    }
+    out.target = SDL_CreateTexture(out.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    return out.target && SDL_SetRenderTarget(out.renderer, out.target);
+}
+
+void destroyTarget(ReplayTarget &out) {
+    SDL_DestroyTexture(out.target);
+    SDL_DestroyRenderer(out.renderer);
+    SDL_DestroySurface(out.surface);
+    SDL_DestroyWindow(out.window);
+}
+
+// stand ins for the textures of the capture, the right size and state with a checker pattern of
+// opaque and transparent cells so blending has something to do
+std::vector<SDL_Texture *> createTextures(SDL_Renderer *renderer, const RenderCapture &capture) {
+    std::vector<SDL_Texture *> textures;
+    std::vector<uint32_t> pixels;
+    for (const RenderCapture::TextureInfo &info : capture.textures) {
+        const int w = std::max(info.w, 1), h = std::max(info.h, 1);
+        SDL_Texture *tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, w, h);
+        if (!tex) {
+            SDL_Log("Couldn't create a %dx%d texture: %s", w, h, SDL_GetError());
+        }
+        pixels.resize(static_cast<size_t>(w) * h);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                pixels[static_cast<size_t>(y) * w + x] = ((x / 8 + y / 8) & 1) ? 0xd08040ffu : 0x00000000u; // RGBA
+            }
+        }
+        SDL_UpdateTexture(tex, nullptr, pixels.data(), w * 4);
+        SDL_SetTextureBlendMode(tex, static_cast<SDL_BlendMode>(info.blend));
+        SDL_SetTextureScaleMode(tex, static_cast<SDL_ScaleMode>(info.scaleMode));
+        textures.push_back(tex);
+    }
+    return textures;
+}
+
+// every command of the capture once
+void replay(SDL_Renderer *renderer, const RenderCapture &capture, const std::vector<SDL_Texture *> &textures,
+            std::vector<SDL_FColor> &colorMods, bool unbatched, ReplayStats &stats) {
+    int32_t lastTexture = -2; // nothing drawn yet
+    uint32_t lastBlend = UINT32_MAX;
+    for (const RenderCapture::Command &cmd : capture.commands) {
+        stats.commands++;
+        switch (cmd.kind) {
+            case RenderCapture::CMD_CLEAR:
+            {
+                SDL_SetRenderDrawColorFloat(renderer, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
+                SDL_RenderClear(renderer);
+                break;
+            }
+            case RenderCapture::CMD_GEOMETRY:
+            {
+                if (cmd.texture != lastTexture) {
+                    stats.textureChanges++;
+                    lastTexture = cmd.texture;
+                }
+                if (cmd.blend != lastBlend) {
+                    stats.blendChanges++;
+                    lastBlend = cmd.blend;
+                }
+                SDL_Texture *tex = cmd.texture >= 0 ? textures[cmd.texture] : nullptr;
+                if (!tex) { // untextured geometry draws with the renderer's blend mode
+                    SDL_SetRenderDrawBlendMode(renderer, static_cast<SDL_BlendMode>(cmd.blend));
+                }
+                if (unbatched && tex && isQuads(capture, cmd)) {
+                    drawQuads(renderer, capture, cmd, tex, colorMods[cmd.texture], stats);
+                } else {
+                    SDL_RenderGeometry(renderer, tex, &capture.vertices[cmd.firstVertex], static_cast<int>(cmd.vertexCount),
+                                       &capture.indices[cmd.firstIndex], static_cast<int>(cmd.indexCount));
+                    stats.drawCalls++;
+                    stats.quads += cmd.indexCount / 6;
+                }
+                break;
+            }
+            case RenderCapture::CMD_FRAME_END:
+            {
+                SDL_FlushRenderer(renderer); // stands in for the present
+                stats.frames++;
+                break;
+            }
+        }
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+// laid out like SpriteBatch writes quads: 4 vertices each, going around from the top left
+bool isQuads(const RenderCapture &capture, const RenderCapture::Command &cmd) {
+    if (cmd.indexCount % 6 != 0 || cmd.vertexCount != cmd.indexCount / 6 * 4) {
+        return false;
+    }
+    for (uint32_t q = 0; q < cmd.indexCount / 6; q++) {
+        if (capture.indices[cmd.firstIndex + q * 6] != static_cast<int>(q * 4)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// turns the quads of one geometry command back into the source rect, flip and color of the
+// sprite they came from and draws each with its own call
+void drawQuads(SDL_Renderer *renderer, const RenderCapture &capture, const RenderCapture::Command &cmd,
+               SDL_Texture *texture, SDL_FColor &colorMod, ReplayStats &stats) {
+    float texW = 1, texH = 1;
+    SDL_GetTextureSize(texture, &texW, &texH);
+    for (uint32_t q = 0; q < cmd.vertexCount / 4; q++) {
+        const SDL_Vertex *v = &capture.vertices[cmd.firstVertex + q * 4]; // top left, top right, bottom right, bottom left
+        const float u0 = v[0].tex_coord.x, v0 = v[0].tex_coord.y, u1 = v[2].tex_coord.x, v1 = v[2].tex_coord.y;
+        const SDL_FRect src {
+            .x = std::min(u0, u1) * texW, .y = std::min(v0, v1) * texH,
+            .w = std::abs(u1 - u0) * texW, .h = std::abs(v1 - v0) * texH
+        };
+        const SDL_FRect dst { .x = v[0].position.x, .y = v[0].position.y,
+                              .w = v[2].position.x - v[0].position.x, .h = v[2].position.y - v[0].position.y };
+        const SDL_FlipMode flip = static_cast<SDL_FlipMode>((u0 > u1 ? SDL_FLIP_HORIZONTAL : 0) | (v0 > v1 ? SDL_FLIP_VERTICAL : 0));
+        const SDL_FColor c = v[0].color;
+        if (c.r != colorMod.r || c.g != colorMod.g || c.b != colorMod.b || c.a != colorMod.a) {
+            SDL_SetTextureColorModFloat(texture, c.r, c.g, c.b);
+            SDL_SetTextureAlphaModFloat(texture, c.a);
+            colorMod = c;
+            stats.colorChanges++;
+        }
+        SDL_RenderTextureRotated(renderer, texture, &src, &dst, 0, nullptr, flip);
+        stats.drawCalls++;
+        stats.quads++;
+    }
+}
+
+// waits until the backend has really drawn everything, reading a pixel back can't happen before
+void finishDrawing(SDL_Renderer *renderer) {
+    const SDL_Rect pixel { .x = 0, .y = 0, .w = 1, .h = 1 };
+    SDL_DestroySurface(SDL_RenderReadPixels(renderer, &pixel));
+}